@@ -1,4 +0,0 @@
-cd shaders
-glslc shader.vert -o vert.spv
-glslc shader.frag -o frag.spv
-cd ..
\ No newline at end of file
@@ -0,0 +1,110 @@
+#version 450
+
+// Matches ExpressionOpcode in copiedImplementation.cpp
+const uint OP_PUSH_CONSTANT = 0;
+const uint OP_PUSH_VARIABLE = 1;
+const uint OP_ADD = 2;
+const uint OP_SUBTRACT = 3;
+const uint OP_MULTIPLY = 4;
+const uint OP_DIVIDE = 5;
+const uint OP_POWER = 6;
+const uint OP_NEGATE = 7;
+const uint OP_SIN = 8;
+const uint OP_COS = 9;
+const uint OP_EXP = 10;
+const uint OP_LOG = 11;
+const uint OP_SQRT = 12;
+
+const float PI = 3.14159265358979;
+
+struct ExpressionInstruction
+{
+    uint opcode;
+    uint variableIndex;
+    vec2 value;
+};
+
+layout(std140, set=0, binding=4) uniform ExpressionData
+{
+    uint instructionCount;
+    ExpressionInstruction instructions[64];
+} expression;
+
+layout(push_constant) uniform PlotPushConstants
+{
+    vec4 viewRange; // xMin, xMax, yMin, yMax
+} pushConstants;
+
+layout(location=0) in vec2 fragUv;
+layout(location=0) out vec4 outColor;
+
+vec2 complexMultiply(vec2 a, vec2 b)
+{
+    return vec2(a.x * b.x - a.y * b.y, a.x * b.y + a.y * b.x);
+}
+
+vec2 complexDivide(vec2 a, vec2 b)
+{
+    return complexMultiply(a, vec2(b.x, -b.y)) / dot(b, b);
+}
+
+vec2 complexExp(vec2 a)
+{
+    return exp(a.x) * vec2(cos(a.y), sin(a.y));
+}
+
+vec2 complexLog(vec2 a)
+{
+    return vec2(log(length(a)), atan(a.y, a.x));
+}
+
+vec2 complexPower(vec2 a, vec2 b)
+{
+    return dot(a, a) == 0.0 ? vec2(0.0) : complexExp(complexMultiply(b, complexLog(a)));
+}
+
+// Interprets the stack machine instructions from ExpressionCompiler
+vec2 evaluate(vec2 z)
+{
+    vec2 stack[16];
+    int top = -1;
+    for (uint i = 0; i < expression.instructionCount; i++) {
+        ExpressionInstruction instruction = expression.instructions[i];
+        switch (instruction.opcode) {
+        case OP_PUSH_CONSTANT: stack[++top] = instruction.value; break;
+        case OP_PUSH_VARIABLE: stack[++top] = z; break;
+        case OP_ADD: top--; stack[top] = stack[top] + stack[top + 1]; break;
+        case OP_SUBTRACT: top--; stack[top] = stack[top] - stack[top + 1]; break;
+        case OP_MULTIPLY: top--; stack[top] = complexMultiply(stack[top], stack[top + 1]); break;
+        case OP_DIVIDE: top--; stack[top] = complexDivide(stack[top], stack[top + 1]); break;
+        case OP_POWER: top--; stack[top] = complexPower(stack[top], stack[top + 1]); break;
+        case OP_NEGATE: stack[top] = -stack[top]; break;
+        case OP_SIN: stack[top] = vec2(sin(stack[top].x) * cosh(stack[top].y), cos(stack[top].x) * sinh(stack[top].y)); break;
+        case OP_COS: stack[top] = vec2(cos(stack[top].x) * cosh(stack[top].y), -sin(stack[top].x) * sinh(stack[top].y)); break;
+        case OP_EXP: stack[top] = complexExp(stack[top]); break;
+        case OP_LOG: stack[top] = complexLog(stack[top]); break;
+        case OP_SQRT: stack[top] = complexPower(stack[top], vec2(0.5, 0.0)); break;
+        }
+    }
+    return top >= 0 ? stack[top] : z;
+}
+
+vec3 hsvToRgb(vec3 hsv)
+{
+    vec3 rgb = clamp(abs(mod(hsv.x * 6.0 + vec3(0.0, 4.0, 2.0), 6.0) - 3.0) - 1.0, 0.0, 1.0);
+    return hsv.z * mix(vec3(1.0), rgb, hsv.y);
+}
+
+// Hue is the argument of f(z), the brightness bands are the contours of log2|f(z)|
+void main()
+{
+    vec2 viewMin = pushConstants.viewRange.xz;
+    vec2 viewMax = pushConstants.viewRange.yw;
+    vec2 z = mix(viewMin, viewMax, vec2(fragUv.x, 1.0 - fragUv.y));
+    vec2 w = evaluate(z);
+
+    float hue = atan(w.y, w.x) / (2.0 * PI) + 0.5;
+    float magnitudeBands = fract(log2(length(w)));
+    float value = 0.6 + 0.4 * magnitudeBands;
+    outColor = vec4(hsvToRgb(vec3(hue, 0.8, value)), 1.0);
+}
\ No newline at end of file
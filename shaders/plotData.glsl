@@ -0,0 +1,36 @@
+// Shared by shader.vert and cull.comp, matches GpuPlotTile and GpuPlotFunction in copiedImplementation.cpp
+
+struct PlotTile
+{
+    vec4 basisOffset; // Dequantisation, value = offset + scale * storedValue
+    vec4 basisScale;
+    vec2 xOffsetScale;
+    vec2 padding;
+    vec4 basisMin; // Basis bounds for culling
+    vec4 basisMax;
+    vec2 xRange;
+    uint functionIndex;
+    int level;
+    uint resident;
+    uint slot;
+    uint format;
+    uint flags;
+};
+
+const uint TILE_FLAG_ANY_LEVEL = 1; // Data plot tiles, which are always built for the current zoom
+
+struct PlotFunction
+{
+    vec4 coefficients;
+    vec4 color;
+};
+
+layout(std430, set=0, binding=0) readonly buffer TileData
+{
+    PlotTile tiles[];
+};
+
+layout(std430, set=0, binding=1) readonly buffer FunctionData
+{
+    PlotFunction functions[];
+};
@@ -1,21 +1,30 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
-layout(location=0) out vec3 fragColor;
-vec2 positions[3] = vec2[](
-    vec2( 0.0, -0.5),
-    vec2( 0.5,  0.5),
-    vec2(-0.5,  0.5)
-);
+#include "plotData.glsl"
+
+layout(location=0) in float inX;
+layout(location=1) in vec4 inBasis;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+layout(push_constant) uniform PlotPushConstants
+{
+    vec4 viewRange; // xMin, xMax, yMin, yMax
+} pushConstants;
+
+layout(location=0) out vec3 fragColor;
 
+// The cull shader sets firstInstance to the tile index. y = dot(coefficients, basis), so coefficient changes
+// never need the mesh to be rebuilt. The tile offset/scale undo the quantization of the packed vertex format.
 void main()
 {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
-    
+    PlotTile tile = tiles[gl_InstanceIndex];
+    PlotFunction function = functions[tile.functionIndex];
+    float x = tile.xOffsetScale.x + tile.xOffsetScale.y * inX;
+    vec4 basis = tile.basisOffset + tile.basisScale * inBasis;
+    vec2 position = vec2(x, dot(function.coefficients, basis));
+    vec2 viewMin = pushConstants.viewRange.xz;
+    vec2 viewMax = pushConstants.viewRange.yw;
+    vec2 normalised = (position - viewMin) / (viewMax - viewMin);
+    gl_Position = vec4(normalised.x * 2.0 - 1.0, 1.0 - normalised.y * 2.0, 0.0, 1.0);
+    fragColor = function.color.rgb;
 }
\ No newline at end of file
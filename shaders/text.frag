@@ -0,0 +1,18 @@
+#version 450
+
+layout(set=0, binding=6) uniform sampler2D glyphAtlas;
+
+layout(location=0) in vec2 fragUv;
+layout(location=1) in vec4 fragColor;
+layout(location=0) out vec4 outColor;
+
+// The atlas holds distances to the glyph edge, with the edge at 0.5. A dark outline a little further out keeps
+// the labels readable over the domain coloring.
+void main()
+{
+    float signedDistance = texture(glyphAtlas, fragUv).r;
+    float width = max(fwidth(signedDistance), 0.0001);
+    float fill = smoothstep(0.5 - width, 0.5 + width, signedDistance);
+    float outline = smoothstep(0.3 - width, 0.3 + width, signedDistance);
+    outColor = vec4(fragColor.rgb * fill, fragColor.a * outline);
+}
@@ -0,0 +1,47 @@
+#version 450
+
+// Matches GpuGlyphInstance in copiedImplementation.cpp
+struct GlyphInstance
+{
+    vec2 anchor; // Plot coordinates
+    vec2 offset; // Pixels from the anchor to the quad's lower left corner, y up
+    vec2 size; // Pixels
+    vec2 clampMask; // 1 for the anchor components kept on screen, the one across the tick's axis
+    vec4 uvRect; // uMin, vMin, uMax, vMax, v going down the atlas
+    vec4 color;
+};
+
+layout(std430, set=0, binding=5) readonly buffer GlyphData
+{
+    GlyphInstance glyphs[];
+};
+
+layout(push_constant) uniform PlotPushConstants
+{
+    vec4 viewRange; // xMin, xMax, yMin, yMax
+    vec2 viewportSize;
+} pushConstants;
+
+layout(location=0) out vec2 fragUv;
+layout(location=1) out vec4 fragColor;
+
+// Axes that are off screen still get their labels, kept this many pixels in from the edge. Only across the
+// axis though, along it the ticks have to move with the view or they'd pile up at the edge.
+const float EDGE_MARGIN = 40.0;
+
+// Two triangles per instance and no vertex buffer. The anchor follows the view, the rest of the quad is in
+// pixels, so the labels stay the same size however far the view is zoomed.
+void main()
+{
+    GlyphInstance glyph = glyphs[gl_InstanceIndex];
+    vec2 corner = vec2((0x32 >> gl_VertexIndex) & 1, (0x2C >> gl_VertexIndex) & 1);
+    vec2 viewMin = pushConstants.viewRange.xz;
+    vec2 viewMax = pushConstants.viewRange.yw;
+    vec2 anchor = (glyph.anchor - viewMin) / (viewMax - viewMin) * pushConstants.viewportSize;
+    vec2 clampedAnchor = clamp(anchor, vec2(EDGE_MARGIN), pushConstants.viewportSize - EDGE_MARGIN);
+    anchor = floor(mix(anchor, clampedAnchor, glyph.clampMask));
+    vec2 normalised = (anchor + glyph.offset + corner * glyph.size) / pushConstants.viewportSize;
+    gl_Position = vec4(normalised.x * 2.0 - 1.0, 1.0 - normalised.y * 2.0, 0.0, 1.0);
+    fragUv = vec2(mix(glyph.uvRect.x, glyph.uvRect.z, corner.x), mix(glyph.uvRect.w, glyph.uvRect.y, corner.y));
+    fragColor = glyph.color;
+}
@@ -1,14 +1,44 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <numeric>
 #include <optional>
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_vulkan.h>
 #include <set>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <vulkan/vulkan.hpp>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pMessenger)
 {
@@ -34,6 +64,8 @@ struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> asyncComputeFamily; // Compute without graphics, only there on some GPUs
+    std::optional<uint32_t> transferFamily; // Transfer only, usually a copy engine that runs alongside everything else
 
     bool isComplete()
     {
@@ -50,294 +82,2971 @@ struct SwapChainSupportDetails
 };
 
 
-class HelloTriangleApplication
+enum class PlotVertexFormat : uint32_t
 {
-public:
-    void run()
-    {
-        _initWindow();
-        _initVulkan();
-        _mainLoop();
-        _cleanup();
-    }
+    Float32,
+    Packed16,
+    Count
+};
 
 
-private:
-    void _initWindow()
-    {
-        if (!SDL_Init(SDL_INIT_VIDEO)) {
-            throw std::runtime_error("Could not initialise SDL");
-        }
+struct FunctionVertex
+{
+    float x;
+    float basis[4];
+};
 
-        _pWindow = SDL_CreateWindow("Vulkan lab copied implementation", 500, 500, SDL_WINDOW_VULKAN);
-        if (!_pWindow) {
-            throw std::runtime_error("Could not create SDL window");
-        }
-    }
 
+// 12 bytes instead of 20. Everything is quantized to 16 bits against the bounds of the tile it belongs to,
+// the vertex fetch turns it back into [0, 1] (R16_UNORM) and shader.vert rescales it with the tile's push constants.
+struct PackedFunctionVertex
+{
+    uint16_t x;
+    uint16_t padding; // Keeps the basis 4 byte aligned, which Metal needs
+    uint16_t basis[4];
+};
 
-    void _initVulkan()
-    {
-        _createInstance();
-        _setupDebugMessenger();
-        _createSurface();
-        _pickPhysicalDevice();
-        _createLogicalDevice();
-        _createSwapChain();
-        _createImageViews();
-        _createRenderPass();
-        _createGraphicsPipeline();
-        _createFrameBuffers();
-        _createCommandPool();
-        _createCommandBuffer();
-    }
 
+// Per tile dequantisation, value = offset + scale * storedValue. For float tiles it's just offset 0 and scale 1.
+struct TileBounds
+{
+    float basisOffset[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float basisScale[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    float xOffset = 0.0f;
+    float xScale = 1.0f;
+    float padding[2] = {0.0f, 0.0f};
+};
 
-    void _mainLoop()
-    {
-        SDL_Event event;
-        while (_isRunning) {
-            while (SDL_PollEvent(&event)) {
-                switch (event.type)
-                {
-                case SDL_EVENT_QUIT:
-                    _isRunning = false;
-                    break;
-                
-                default:
-                    break;
-                }
-            }
-            SDL_Delay(16);
-        }
 
-    }
+// The structs below match the ones in shaders/plotData.glsl (std430)
+struct GpuPlotTile
+{
+    TileBounds dequantisation;
+    float basisMin[4]; // Used by the cull shader to bound y for the current coefficients
+    float basisMax[4];
+    float xRange[2];
+    uint32_t functionIndex;
+    int32_t level;
+    uint32_t resident;
+    uint32_t slot;
+    uint32_t format;
+    uint32_t flags; // GpuPlotTileFlags
+};
 
 
-    void _cleanup()
-    {
-        vkDestroyCommandPool(_device, _commandPool, nullptr);
-        for (VkFramebuffer& frameBuffer : _swapchainFrameBuffers) {
-            vkDestroyFramebuffer(_device, frameBuffer, nullptr);
-        }
-        vkDestroyPipeline(_device, _graphicsPipeline, nullptr);
-        vkDestroyPipelineLayout(_device, _pipelineLayout, nullptr);
-        vkDestroyRenderPass(_device, _renderPass, nullptr);
-        for (const VkImageView imageView : _swapchainImageViews) {
-            vkDestroyImageView(_device, imageView, nullptr);
-        }
-        vkDestroySwapchainKHR(_device, _swapchain, nullptr);
-        vkDestroyDevice(_device, nullptr);
-        SDL_Vulkan_DestroySurface(_instance, _surface, nullptr);
-        if (_enableValidationLayers) {
-            DestroyDebugUtilsMessengerEXT(_instance, _debugMessenger, nullptr);
-        }
-        vkDestroyInstance(_instance, nullptr);
-        SDL_DestroyWindow(_pWindow);
-        SDL_Quit();
-    }
+enum GpuPlotTileFlags : uint32_t
+{
+    GPU_PLOT_TILE_ANY_LEVEL = 1 // Data plot tiles are rebuilt for the current zoom, so the cull shader mustn't check their level
+};
 
 
-    void _createInstance()
-    {
-        if (_enableValidationLayers && !_checkValidationLayerSupport()) {
-            throw std::runtime_error("Validation layers requested, but none are supported");
-        }
+struct GpuPlotFunction
+{
+    float coefficients[4];
+    float color[4];
+};
 
-        VkApplicationInfo appInfo{};
-        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
-        appInfo.apiVersion = VK_API_VERSION_1_0;
-        appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 2);
-        appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 2);
-        appInfo.pApplicationName = "Vulkan lab";
-        appInfo.pEngineName = "No engine";
 
-        VkInstanceCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
-        createInfo.pApplicationInfo = &appInfo;
-        createInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
-        std::vector<const char*> requiredExtensions = _getRequiredExtensions();
-        createInfo.enabledExtensionCount = requiredExtensions.size();
-        createInfo.ppEnabledExtensionNames = requiredExtensions.data();
+struct PlotPushConstants
+{
+    float viewRange[4]; // xMin, xMax, yMin, yMax
+    float viewportSize[2]; // Only the text shader needs it, to place glyphs in whole pixels
+};
 
-        VkDebugUtilsMessengerCreateInfoEXT debugMessengerCreateInfo{};
-        if (_enableValidationLayers) {
-            createInfo.enabledLayerCount = static_cast<uint32_t>(_validationLayers.size());
-            createInfo.ppEnabledLayerNames = _validationLayers.data();
-            _populateDebugMessengerCreateInfo(&debugMessengerCreateInfo);
-            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debugMessengerCreateInfo;
-        } else {
-            createInfo.enabledLayerCount = 0;
-        }
 
-        VkResult result = vkCreateInstance(&createInfo, nullptr, &_instance);
-        if (result != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create vulkan instance");
-        }
+// One textured quad of the label text, see shaders/text.vert
+struct GpuGlyphInstance
+{
+    float anchor[2]; // Plot coordinates, the tick the quad belongs to
+    float offset[2]; // Pixels from the anchor to the quad's lower left corner, y up
+    float size[2]; // Pixels
+    float clampMask[2]; // 1 for the anchor components kept on screen, the one across the tick's axis
+    float uvRect[4]; // uMin, vMin, uMax, vMax in the glyph atlas, v going down
+    float color[4];
+};
 
-        uint32_t extensionCount = 0;
-        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
-        std::vector<VkExtensionProperties> extensions(extensionCount);
-        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
-        std::cout << "Available extensions:\n";
-        for (VkExtensionProperties& extension : extensions) {
-            std::cout << "\t" << extension.extensionName << "\n";
-        }
-    }
 
+struct CullPushConstants
+{
+    float viewRange[4];
+    int32_t level;
+    uint32_t tileCount;
+    uint32_t tilesPerFormat;
+    uint32_t sampleCount;
+    uint32_t tilesPerChunk; // Each chunk of a tile pool has its own vertex buffer and so its own draw list
+};
 
-    bool _checkValidationLayerSupport()
-    {
-        uint32_t layerCount = 0;
-        vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
-        std::vector<VkLayerProperties> availableLayers(layerCount);
-        vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
 
-        for (const char* pLayerName : _validationLayers) {
-            bool layerFound = false;
-            for (const VkLayerProperties& layerProperties : availableLayers) {
-                if (strcmp(pLayerName, layerProperties.layerName) == 0) {
-                    layerFound = true;
-                    break;
-                }
-            }
+// Both ignore NaNs when finding the range, so a tile's bounds stay usable when some of its samples are undefined.
+// quantizeToUnorm16 needs every value to be finite, the float to int conversion is undefined otherwise.
+#if defined(__GNUC__) || defined(__clang__)
+// GCC/Clang vector extensions, so this compiles to SSE on x86 and NEON on Apple silicon without any intrinsics.
+// Both functions below work 4 floats at a time, so count has to be a multiple of 4.
+typedef float Float4 __attribute__((vector_size(16)));
+typedef int32_t Int4 __attribute__((vector_size(16)));
 
-            if (!layerFound) {
-                return false;
-            }
-        }
-        return true;
-    }
 
+inline Float4 selectFloat4(Int4 mask, Float4 a, Float4 b)
+{
+    return (Float4)(((Int4)a & mask) | ((Int4)b & ~mask));
+}
 
-    std::vector<const char*> _getRequiredExtensions()
-    {
-        uint32_t SDLExtensionCount = 0;
-        const char* const* ppSDLExtensionNames = SDL_Vulkan_GetInstanceExtensions(&SDLExtensionCount);
-        std::vector<const char*> requiredExtensions(ppSDLExtensionNames, ppSDLExtensionNames + SDLExtensionCount);
-        requiredExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
 
-        if (_enableValidationLayers) {
-            requiredExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
-        }
+void findMinMax(const float* pValues, size_t count, float* pMin, float* pMax)
+{
+    const float infinity = std::numeric_limits<float>::infinity();
+    Float4 minVector = {infinity, infinity, infinity, infinity};
+    Float4 maxVector = -minVector;
+    for (size_t i = 0; i < count; i += 4) {
+        Float4 values;
+        std::memcpy(&values, pValues + i, sizeof(Float4));
+        minVector = selectFloat4(values < minVector, values, minVector);
+        maxVector = selectFloat4(values > maxVector, values, maxVector);
+    }
+    *pMin = std::min(std::min(minVector[0], minVector[1]), std::min(minVector[2], minVector[3]));
+    *pMax = std::max(std::max(maxVector[0], maxVector[1]), std::max(maxVector[2], maxVector[3]));
+}
 
-        std::cout << "\nRequired Extensions:\n";
-        for (const char* const& extension : requiredExtensions) {
-            std::cout << "\t" << extension << "\n";
-        }
 
-        return requiredExtensions;
+// Quantizes to 16 bit unorm against [minValue, maxValue], writing every 'outputStride'th uint16_t
+void quantizeToUnorm16(const float* pValues, size_t count, float minValue, float maxValue, uint16_t* pOutput, size_t outputStride)
+{
+    float range = maxValue - minValue;
+    float invScale = range > 0.0f ? 65535.0f / range : 0.0f;
+    Float4 minVector = {minValue, minValue, minValue, minValue};
+    Float4 invScaleVector = {invScale, invScale, invScale, invScale};
+    Float4 zero = {0.0f, 0.0f, 0.0f, 0.0f};
+    Float4 maxQuantized = {65535.0f, 65535.0f, 65535.0f, 65535.0f};
+    Float4 half = {0.5f, 0.5f, 0.5f, 0.5f};
+    for (size_t i = 0; i < count; i += 4) {
+        Float4 values;
+        std::memcpy(&values, pValues + i, sizeof(Float4));
+        Float4 scaled = (values - minVector) * invScaleVector + half;
+        scaled = selectFloat4(scaled < zero, zero, scaled);
+        scaled = selectFloat4(scaled > maxQuantized, maxQuantized, scaled);
+        Int4 quantized = __builtin_convertvector(scaled, Int4);
+        for (size_t lane = 0; lane < 4; lane++) {
+            pOutput[(i + lane) * outputStride] = static_cast<uint16_t>(quantized[lane]);
+        }
     }
+}
+#else
+// Plain loops for compilers without the vector extensions (MSVC), left to the auto-vectoriser
+void findMinMax(const float* pValues, size_t count, float* pMin, float* pMax)
+{
+    *pMin = std::numeric_limits<float>::infinity();
+    *pMax = -std::numeric_limits<float>::infinity();
+    for (size_t i = 0; i < count; i++) {
+        *pMin = pValues[i] < *pMin ? pValues[i] : *pMin;
+        *pMax = pValues[i] > *pMax ? pValues[i] : *pMax;
+    }
+}
 
 
-    static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
-        VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
-        VkDebugUtilsMessageTypeFlagsEXT messageType,
-        const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
-        void* pUserData
-    ) {
-        std::cerr << "Validation Layer Reports: " << pCallbackData->pMessage << "\n";
-        return VK_FALSE;
+void quantizeToUnorm16(const float* pValues, size_t count, float minValue, float maxValue, uint16_t* pOutput, size_t outputStride)
+{
+    float range = maxValue - minValue;
+    float invScale = range > 0.0f ? 65535.0f / range : 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        float scaled = std::clamp((pValues[i] - minValue) * invScale + 0.5f, 0.0f, 65535.0f);
+        pOutput[i * outputStride] = static_cast<uint16_t>(scaled);
     }
+}
+#endif
 
 
-    void _populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo)
+// A function of the form y = c0*f0(x) + c1*f1(x) + c2*f2(x) + c3*f3(x).
+// The terms f0..f3 are the structure of the expression and are what gets baked into the mesh,
+// the coefficients enter linearly so they're applied in the vertex shader and never need a re-mesh.
+class PlotFunction
+{
+public:
+    static const uint32_t maxTerms = 4;
+
+    void setTerms(const std::vector<std::function<float(float)>>& terms)
     {
-        pCreateInfo->sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-        pCreateInfo->messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
-        pCreateInfo->messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
-        pCreateInfo->pfnUserCallback = debugCallback;
-        pCreateInfo->pUserData = nullptr;
+        if (terms.size() > maxTerms) {
+            throw std::runtime_error("A plot function can have at most 4 terms");
+        }
+        _terms = terms;
+        _structureRevision++;
     }
 
+    void setCoefficient(uint32_t index, float value)
+    {
+        _coefficients[index] = value;
+    }
 
-    void _setupDebugMessenger()
+    float getCoefficient(uint32_t index) const
     {
-        if (!_enableValidationLayers) {
-            return;
-        }
-        VkDebugUtilsMessengerCreateInfoEXT createInfo{};
-        _populateDebugMessengerCreateInfo(&createInfo);
-        createInfo.pUserData = nullptr;
+        return _coefficients[index];
+    }
 
-        if (CreateDebugUtilsMessengerEXT(_instance, &createInfo, nullptr, &_debugMessenger) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create DebugUtilsMessenger");
-        }
+    // Switching format means the tiles have to go into a different buffer, so it counts as a structural change
+    void setVertexFormat(PlotVertexFormat format)
+    {
+        _vertexFormat = format;
+        _structureRevision++;
     }
 
+    PlotVertexFormat getVertexFormat() const
+    {
+        return _vertexFormat;
+    }
 
-    void _pickPhysicalDevice()
+    void setColor(float r, float g, float b)
     {
-        uint32_t deviceCount = 0;
-        vkEnumeratePhysicalDevices(_instance, &deviceCount, nullptr);
-        if (deviceCount == 0) {
-            throw std::runtime_error("Failed to find GPUs that support Vulkan");
-        }
-        std::vector<VkPhysicalDevice> devices(deviceCount);
-        vkEnumeratePhysicalDevices(_instance, &deviceCount, devices.data());
+        _color[0] = r;
+        _color[1] = g;
+        _color[2] = b;
+    }
 
-        for (const VkPhysicalDevice& device : devices) {
-            if (_isDeviceSuitable(device)) {
-                _physicalDevice = device;
-                break;
-            }
-        }
+    uint64_t getStructureRevision() const
+    {
+        return _structureRevision;
+    }
 
-        if (_physicalDevice == VK_NULL_HANDLE) {
-            throw std::runtime_error("You have GPU/s that support Vulkan, though are not suitable for this program.");
+    void fillGpuData(GpuPlotFunction* pGpuFunction) const
+    {
+        for (uint32_t i = 0; i < maxTerms; i++) {
+            pGpuFunction->coefficients[i] = _coefficients[i];
+            pGpuFunction->color[i] = _color[i];
         }
     }
 
-
-    bool _isDeviceSuitable(VkPhysicalDevice device)
+    // pColumns holds 1 + maxTerms columns of sampleCount floats each: x first, then one per term
+    void evaluateTile(float xStart, float xEnd, uint32_t sampleCount, float* pColumns) const
     {
-        QueueFamilyIndices indices = _findQueueFamilies(device);
-        bool extensionsSupported = _checkDeviceExtensionSupport(device);
-        bool swapchainAdequate = false;
-        if (extensionsSupported) {
-            SwapChainSupportDetails swapchainSupport = _querySwapChainSupport(device);
-            swapchainAdequate = !swapchainSupport.formats.empty() && !swapchainSupport.presentModes.empty();
+        for (uint32_t i = 0; i < sampleCount; i++) {
+            float x = xStart + (xEnd - xStart) * static_cast<float>(i) / static_cast<float>(sampleCount - 1);
+            pColumns[i] = x;
+            for (uint32_t term = 0; term < maxTerms; term++) {
+                pColumns[(term + 1) * sampleCount + i] = term < _terms.size() ? _terms[term](x) : 0.0f;
+            }
         }
-        return indices.isComplete() && extensionsSupported && swapchainAdequate;
     }
 
 
-    QueueFamilyIndices _findQueueFamilies(VkPhysicalDevice device)
-    {
-        QueueFamilyIndices indices;
+private:
+    std::vector<std::function<float(float)>> _terms;
+    float _coefficients[maxTerms] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float _color[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    PlotVertexFormat _vertexFormat = PlotVertexFormat::Float32;
+    uint64_t _structureRevision = 0;
+};
 
-        uint32_t queueFamilyCount = 0;
-        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
-        uint32_t i = 0;
-        for (const VkQueueFamilyProperties& queueFamily : queueFamilies) {
-            if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-                indices.graphicsFamily = i;
-            }
+// Tiles split the x axis into power of two widths (the level), so panning only evaluates the tiles that scroll into view.
+struct PlotTileKey
+{
+    const PlotFunction* pFunction;
+    int32_t level;
+    int64_t index;
 
-            VkBool32 presentSupport = VK_FALSE;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _surface, &presentSupport);
-            if (presentSupport) {
-                indices.presentFamily = i;
-            }
+    bool operator<(const PlotTileKey& other) const
+    {
+        return std::tie(pFunction, level, index) < std::tie(other.pFunction, other.level, other.index);
+    }
+};
 
-            if (indices.isComplete()) {
-                break;
-            }
-            i++;
-        }
 
-        return indices;
-    }
+struct ResidentPlotTile
+{
+    uint32_t slot;
+    PlotVertexFormat format;
+    uint64_t structureRevision;
+    uint64_t lastUsedFrame;
+};
 
 
-    void _createLogicalDevice()
-    {
-        QueueFamilyIndices indices = _findQueueFamilies(_physicalDevice);
-        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+// A tile evicted under memory pressure, kept encoded so bringing it back is a copy rather than a re-evaluation
+struct HostCachedPlotTile
+{
+    PlotVertexFormat format;
+    uint64_t structureRevision;
+    GpuPlotTile gpuTile;
+    std::vector<uint8_t> vertices;
+};
+
+
+// A run of a tile pool's slots with its own device local vertex buffer and the persistently mapped staging
+// buffer the tiles get encoded into. Only allocated once one of its slots is used.
+struct PlotTileChunk
+{
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingBufferMemory = VK_NULL_HANDLE;
+    void* pStagingData = nullptr;
+    uint32_t usedSlotCount = 0;
+    std::vector<VkBufferCopy> pendingCopies;
+};
+
+
+// One pool per vertex format, split into a slot per resident tile. Free slots are handed out lowest first, so
+// the tiles pack into the first chunks and the last ones can empty out and be freed under memory pressure.
+struct PlotTilePool
+{
+    VkDeviceSize vertexSize = 0;
+    std::vector<PlotTileChunk> chunks;
+    std::set<uint32_t> freeSlots;
+};
+
+
+// Data files are columnar: the header, then sampleCount x values (ascending), then sampleCount y values, all float32
+struct DataFileHeader
+{
+    char magic[4]; // "VLDS"
+    uint32_t version;
+    uint64_t sampleCount;
+};
+
+
+// Bucket i covers samples [i * samplesPerBucket, (i + 1) * samplesPerBucket)
+struct DataPyramidLevel
+{
+    uint64_t samplesPerBucket;
+    std::vector<float> x; // x of the first sample in the bucket
+    std::vector<float> yMin;
+    std::vector<float> yMax;
+};
+
+
+// A read only memory mapping of a whole file, through mmap or CreateFileMapping depending on the platform
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (_pData != nullptr) {
+            UnmapViewOfFile(_pData);
+        }
+        if (_mapping != nullptr) {
+            CloseHandle(_mapping);
+        }
+        if (_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(_file);
+        }
+#else
+        if (_pData != nullptr) {
+            munmap(_pData, _size);
+        }
+        if (_fileDescriptor >= 0) {
+            close(_fileDescriptor);
+        }
+#endif
+    }
+
+    void open(const std::string& path)
+    {
+#ifdef _WIN32
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open " + path);
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(_file, &fileSize);
+        _size = static_cast<size_t>(fileSize.QuadPart);
+        if (_size == 0) {
+            return; // Empty files can't be mapped
+        }
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (_mapping != nullptr) {
+            _pData = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+        if (_pData == nullptr) {
+            throw std::runtime_error("Failed to memory map " + path);
+        }
+#else
+        _fileDescriptor = ::open(path.c_str(), O_RDONLY);
+        if (_fileDescriptor < 0) {
+            throw std::runtime_error("Failed to open " + path);
+        }
+        struct stat fileStatus;
+        fstat(_fileDescriptor, &fileStatus);
+        _size = static_cast<size_t>(fileStatus.st_size);
+        if (_size == 0) {
+            return;
+        }
+        _pData = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fileDescriptor, 0);
+        if (_pData == MAP_FAILED) {
+            _pData = nullptr;
+            throw std::runtime_error("Failed to memory map " + path);
+        }
+#endif
+    }
+
+    const void* getData() const
+    {
+        return _pData;
+    }
+
+    size_t getSize() const
+    {
+        return _size;
+    }
+
+
+private:
+#ifdef _WIN32
+    HANDLE _file = INVALID_HANDLE_VALUE;
+    HANDLE _mapping = nullptr;
+#else
+    int _fileDescriptor = -1;
+#endif
+    void* _pData = nullptr;
+    size_t _size = 0;
+};
+
+
+// Memory maps a data file and builds a min/max pyramid over it, so that however many samples there are
+// only about two vertices per pixel ever get built and uploaded. The samples themselves stay in the page cache.
+class DataPlotSource
+{
+public:
+    static const uint64_t baseBucketSize = 64;
+
+    void open(const std::string& path)
+    {
+        _file.open(path);
+        if (_file.getSize() < sizeof(DataFileHeader)) {
+            throw std::runtime_error("Data file " + path + " is too small");
+        }
+
+        const DataFileHeader* pHeader = static_cast<const DataFileHeader*>(_file.getData());
+        if (std::memcmp(pHeader->magic, "VLDS", 4) != 0 || pHeader->version != 1) {
+            throw std::runtime_error("Data file " + path + " isn't a version 1 VLDS file");
+        }
+        _sampleCount = pHeader->sampleCount;
+        if (_sampleCount == 0 || _sampleCount > (_file.getSize() - sizeof(DataFileHeader)) / (2 * sizeof(float))) {
+            throw std::runtime_error("Data file " + path + " is truncated");
+        }
+        _pX = reinterpret_cast<const float*>(pHeader + 1);
+        _pY = _pX + _sampleCount;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (!_buildPyramid()) {
+            throw std::runtime_error("Data file " + path + " doesn't have its x values in ascending order");
+        }
+        std::cout << "Loaded " << _sampleCount << " samples from " << path << ", built " << _levels.size() << " pyramid levels in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << "ms\n";
+    }
+
+    // A noisy sine wave, for trying out data plots without having a real data set around. Written a chunk at a
+    // time, so files far bigger than memory can be made.
+    static void writeTestFile(const std::string& path, uint64_t sampleCount)
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to create data file " + path);
+        }
+        DataFileHeader header = {{'V', 'L', 'D', 'S'}, 1, sampleCount};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const uint64_t chunkSize = 1 << 20;
+        std::vector<float> chunk;
+        auto getX = [sampleCount](uint64_t i) {
+            return -10.0f + 20.0f * static_cast<float>(i) / static_cast<float>(sampleCount);
+        };
+        for (uint64_t first = 0; first < sampleCount; first += chunkSize) {
+            chunk.resize(std::min(chunkSize, sampleCount - first));
+            for (uint64_t i = 0; i < chunk.size(); i++) {
+                chunk[i] = getX(first + i);
+            }
+            file.write(reinterpret_cast<const char*>(chunk.data()), sizeof(float) * chunk.size());
+        }
+        for (uint64_t first = 0; first < sampleCount; first += chunkSize) {
+            chunk.resize(std::min(chunkSize, sampleCount - first));
+            for (uint64_t i = 0; i < chunk.size(); i++) {
+                float noise = static_cast<float>(std::rand()) / RAND_MAX - 0.5f;
+                chunk[i] = std::sin(getX(first + i) * 3.0f) + 0.3f * noise;
+            }
+            file.write(reinterpret_cast<const char*>(chunk.data()), sizeof(float) * chunk.size());
+        }
+        if (!file) {
+            throw std::runtime_error("Failed to write data file " + path);
+        }
+    }
+
+    // Appends the vertices for [xMin, xMax] to pVertices, from the finest level that fits in maxVertexCount.
+    // Raw samples are one vertex each, buckets are two (their min and max) so the line strip draws the envelope.
+    void buildVertices(float xMin, float xMax, uint32_t maxVertexCount, std::vector<FunctionVertex>* pVertices) const
+    {
+        uint64_t first = std::lower_bound(_pX, _pX + _sampleCount, xMin) - _pX;
+        uint64_t last = std::upper_bound(_pX, _pX + _sampleCount, xMax) - _pX;
+        first = first > 0 ? first - 1 : 0; // One sample either side so the line reaches the edge of the view
+        last = std::min(last + 1, _sampleCount);
+
+        if (last - first <= maxVertexCount) {
+            for (uint64_t i = first; i < last; i++) {
+                pVertices->push_back({_pX[i], {_pY[i], 0.0f, 0.0f, 0.0f}});
+            }
+            return;
+        }
+
+        for (const DataPyramidLevel& level : _levels) {
+            uint64_t firstBucket = first / level.samplesPerBucket;
+            uint64_t lastBucket = std::min((last - 1) / level.samplesPerBucket + 1, static_cast<uint64_t>(level.x.size()));
+            if (2 * (lastBucket - firstBucket) > maxVertexCount && &level != &_levels.back()) {
+                continue;
+            }
+            lastBucket = std::min(lastBucket, firstBucket + maxVertexCount / 2);
+            for (uint64_t bucket = firstBucket; bucket < lastBucket; bucket++) {
+                pVertices->push_back({level.x[bucket], {level.yMin[bucket], 0.0f, 0.0f, 0.0f}});
+                pVertices->push_back({level.x[bucket], {level.yMax[bucket], 0.0f, 0.0f, 0.0f}});
+            }
+            return;
+        }
+    }
+
+
+private:
+    // The base level is a pass over every sample so it's split across threads, the levels above only halve it.
+    // The same pass checks the x values are ascending, which the binary searches rely on; returns false if not.
+    bool _buildPyramid()
+    {
+        DataPyramidLevel baseLevel;
+        baseLevel.samplesPerBucket = baseBucketSize;
+        uint64_t bucketCount = (_sampleCount + baseBucketSize - 1) / baseBucketSize;
+        baseLevel.x.resize(bucketCount);
+        baseLevel.yMin.resize(bucketCount);
+        baseLevel.yMax.resize(bucketCount);
+
+        uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+        uint64_t bucketsPerThread = (bucketCount + threadCount - 1) / threadCount;
+        std::atomic<bool> ascending = true;
+        std::vector<std::thread> threads;
+        for (uint32_t thread = 0; thread < threadCount; thread++) {
+            uint64_t firstBucket = thread * bucketsPerThread;
+            uint64_t lastBucket = std::min(firstBucket + bucketsPerThread, bucketCount);
+            if (firstBucket >= lastBucket) {
+                break;
+            }
+            threads.emplace_back([this, &baseLevel, &ascending, firstBucket, lastBucket]() {
+                for (uint64_t bucket = firstBucket; bucket < lastBucket; bucket++) {
+                    uint64_t firstSample = bucket * baseBucketSize;
+                    uint64_t lastSample = std::min(firstSample + baseBucketSize, _sampleCount);
+                    // Up to the next bucket's first sample, so the pairs across bucket edges are checked too. Written
+                    // as !(a <= b) so NaNs fail it.
+                    const float* pXEnd = _pX + std::min(lastSample + 1, _sampleCount);
+                    if (std::adjacent_find(_pX + firstSample, pXEnd, [](float a, float b) { return !(a <= b); }) != pXEnd) {
+                        ascending = false;
+                        return;
+                    }
+                    auto [minIt, maxIt] = std::minmax_element(_pY + firstSample, _pY + lastSample);
+                    baseLevel.x[bucket] = _pX[firstSample];
+                    baseLevel.yMin[bucket] = *minIt;
+                    baseLevel.yMax[bucket] = *maxIt;
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        if (!ascending) {
+            return false;
+        }
+        _levels.push_back(std::move(baseLevel));
+
+        while (_levels.back().x.size() > 1) {
+            const DataPyramidLevel& below = _levels.back();
+            DataPyramidLevel level;
+            level.samplesPerBucket = below.samplesPerBucket * 2;
+            for (size_t bucket = 0; bucket < below.x.size(); bucket += 2) {
+                size_t other = std::min(bucket + 1, below.x.size() - 1);
+                level.x.push_back(below.x[bucket]);
+                level.yMin.push_back(std::min(below.yMin[bucket], below.yMin[other]));
+                level.yMax.push_back(std::max(below.yMax[bucket], below.yMax[other]));
+            }
+            _levels.push_back(std::move(level));
+        }
+        return true;
+    }
+
+
+private:
+    MappedFile _file;
+    const float* _pX = nullptr;
+    const float* _pY = nullptr;
+    uint64_t _sampleCount = 0;
+    std::vector<DataPyramidLevel> _levels;
+};
+
+
+enum class ExpressionOpcode : uint32_t
+{
+    PushConstant,
+    PushVariable,
+    Add,
+    Subtract,
+    Multiply,
+    Divide,
+    Power,
+    Negate,
+    Sin,
+    Cos,
+    Exp,
+    Log,
+    Sqrt
+};
+
+
+struct ExpressionInstruction
+{
+    ExpressionOpcode opcode;
+    uint32_t variableIndex;
+    float value[2]; // Real and imaginary part for PushConstant
+};
+
+
+// Matches the ExpressionData uniform block in domainColoring.frag (std140)
+struct GpuExpression
+{
+    uint32_t instructionCount;
+    uint32_t padding[3];
+    ExpressionInstruction instructions[64];
+};
+
+
+// Compiles expressions like "(z^2 - 1) / (z - i)" into stack machine instructions (reverse polish notation),
+// which the shaders can interpret without being recompiled whenever the expression changes.
+// Supports + - * / ^, unary minus, implicit multiplication ("2z"), i, sin, cos, exp, log and sqrt.
+class ExpressionCompiler
+{
+public:
+    static const uint32_t maxInstructions = 64;
+    static const uint32_t maxStackDepth = 16;
+
+    std::vector<ExpressionInstruction> compile(const std::string& expression, const std::vector<std::string>& variableNames)
+    {
+        _expression = expression;
+        _variableNames = variableNames;
+        _position = 0;
+        _instructions.clear();
+        _stackDepth = 0;
+        _maxStackDepthReached = 0;
+
+        _parseSum();
+        _skipWhitespace();
+        if (_position != _expression.size()) {
+            throw std::runtime_error("Unexpected '" + _expression.substr(_position, 1) + "' in expression " + _expression);
+        }
+        if (_instructions.size() > maxInstructions || _maxStackDepthReached > maxStackDepth) {
+            throw std::runtime_error("Expression is too long: " + _expression);
+        }
+        return _instructions;
+    }
+
+
+private:
+    void _parseSum()
+    {
+        _parseProduct();
+        while (true) {
+            char next = _peek();
+            if (next != '+' && next != '-') {
+                return;
+            }
+            _position++;
+            _parseProduct();
+            _emit(next == '+' ? ExpressionOpcode::Add : ExpressionOpcode::Subtract, -1);
+        }
+    }
+
+    void _parseProduct()
+    {
+        _parseUnary();
+        while (true) {
+            char next = _peek();
+            if (next == '*' || next == '/') {
+                _position++;
+                _parseUnary();
+                _emit(next == '*' ? ExpressionOpcode::Multiply : ExpressionOpcode::Divide, -1);
+            } else if (std::isalnum(static_cast<unsigned char>(next)) || next == '.' || next == '(') {
+                _parseUnary(); // Implicit multiplication, like 2z or (z + 1)(z - 1)
+                _emit(ExpressionOpcode::Multiply, -1);
+            } else {
+                return;
+            }
+        }
+    }
+
+    void _parseUnary()
+    {
+        if (_peek() == '-') {
+            _position++;
+            _parseUnary();
+            _emit(ExpressionOpcode::Negate, 0);
+            return;
+        }
+        _parsePower();
+    }
+
+    void _parsePower()
+    {
+        _parsePrimary();
+        if (_peek() == '^') {
+            _position++;
+            _parseUnary(); // Right associative, so z^2^3 is z^(2^3)
+            _emit(ExpressionOpcode::Power, -1);
+        }
+    }
+
+    void _parsePrimary()
+    {
+        char next = _peek();
+        if (next == '(') {
+            _position++;
+            _parseSum();
+            _expect(')');
+            return;
+        }
+
+        if (std::isdigit(static_cast<unsigned char>(next)) || next == '.') {
+            size_t length = 0;
+            float value = std::stof(_expression.substr(_position), &length);
+            _position += length;
+            _emitConstant(value, 0.0f);
+            return;
+        }
+
+        if (!std::isalpha(static_cast<unsigned char>(next))) {
+            throw std::runtime_error("Expected a number, variable or function in expression " + _expression);
+        }
+        size_t start = _position;
+        while (_position < _expression.size() && std::isalnum(static_cast<unsigned char>(_expression[_position]))) {
+            _position++;
+        }
+        std::string name = _expression.substr(start, _position - start);
+
+        for (uint32_t i = 0; i < _variableNames.size(); i++) {
+            if (name == _variableNames[i]) {
+                ExpressionInstruction instruction{};
+                instruction.opcode = ExpressionOpcode::PushVariable;
+                instruction.variableIndex = i;
+                _instructions.push_back(instruction);
+                _changeStackDepth(1);
+                return;
+            }
+        }
+        if (name == "i") {
+            _emitConstant(0.0f, 1.0f);
+            return;
+        }
+
+        static const std::map<std::string, ExpressionOpcode> functions = {
+            {"sin", ExpressionOpcode::Sin},
+            {"cos", ExpressionOpcode::Cos},
+            {"exp", ExpressionOpcode::Exp},
+            {"log", ExpressionOpcode::Log},
+            {"sqrt", ExpressionOpcode::Sqrt}
+        };
+        auto function = functions.find(name);
+        if (function == functions.end()) {
+            throw std::runtime_error("Unknown name '" + name + "' in expression " + _expression);
+        }
+        _expect('(');
+        _parseSum();
+        _expect(')');
+        _emit(function->second, 0);
+    }
+
+    char _peek()
+    {
+        _skipWhitespace();
+        return _position < _expression.size() ? _expression[_position] : '\0';
+    }
+
+    void _skipWhitespace()
+    {
+        while (_position < _expression.size() && std::isspace(static_cast<unsigned char>(_expression[_position]))) {
+            _position++;
+        }
+    }
+
+    void _expect(char character)
+    {
+        if (_peek() != character) {
+            throw std::runtime_error(std::string("Expected '") + character + "' in expression " + _expression);
+        }
+        _position++;
+    }
+
+    void _emitConstant(float real, float imaginary)
+    {
+        ExpressionInstruction instruction{};
+        instruction.opcode = ExpressionOpcode::PushConstant;
+        instruction.value[0] = real;
+        instruction.value[1] = imaginary;
+        _instructions.push_back(instruction);
+        _changeStackDepth(1);
+    }
+
+    void _emit(ExpressionOpcode opcode, int32_t stackChange)
+    {
+        ExpressionInstruction instruction{};
+        instruction.opcode = opcode;
+        _instructions.push_back(instruction);
+        _changeStackDepth(stackChange);
+    }
+
+    void _changeStackDepth(int32_t change)
+    {
+        _stackDepth += change;
+        _maxStackDepthReached = std::max(_maxStackDepthReached, static_cast<uint32_t>(_stackDepth));
+    }
+
+
+private:
+    std::string _expression;
+    std::vector<std::string> _variableNames;
+    size_t _position = 0;
+    std::vector<ExpressionInstruction> _instructions;
+    int32_t _stackDepth = 0;
+    uint32_t _maxStackDepthReached = 0;
+};
+
+
+// Evaluates compiled expressions on the CPU over a whole batch of real inputs at a time. Every instruction is a loop
+// over the batch on a stack of columns, which the compiler can vectorise. Imaginary parts of constants are ignored.
+class ExpressionEvaluator
+{
+public:
+    explicit ExpressionEvaluator(const std::vector<ExpressionInstruction>& instructions) : _instructions(instructions)
+    {
+    }
+
+
+    // ppVariables holds a column of count values for each variable the expression was compiled with
+    void evaluate(const float* const* ppVariables, size_t count, float* pOutput)
+    {
+        _stack.resize(ExpressionCompiler::maxStackDepth * count);
+        uint32_t depth = 0;
+        for (const ExpressionInstruction& instruction : _instructions) {
+            float* pNext = _stack.data() + depth * count;
+            float* pTop = depth > 0 ? pNext - count : pNext;
+            float* pSecond = depth > 1 ? pTop - count : pTop;
+            switch (instruction.opcode) {
+            case ExpressionOpcode::PushConstant:
+                std::fill(pNext, pNext + count, instruction.value[0]);
+                depth++;
+                break;
+            case ExpressionOpcode::PushVariable:
+                std::copy(ppVariables[instruction.variableIndex], ppVariables[instruction.variableIndex] + count, pNext);
+                depth++;
+                break;
+            case ExpressionOpcode::Add:
+                for (size_t i = 0; i < count; i++) pSecond[i] += pTop[i];
+                depth--;
+                break;
+            case ExpressionOpcode::Subtract:
+                for (size_t i = 0; i < count; i++) pSecond[i] -= pTop[i];
+                depth--;
+                break;
+            case ExpressionOpcode::Multiply:
+                for (size_t i = 0; i < count; i++) pSecond[i] *= pTop[i];
+                depth--;
+                break;
+            case ExpressionOpcode::Divide:
+                for (size_t i = 0; i < count; i++) pSecond[i] /= pTop[i];
+                depth--;
+                break;
+            case ExpressionOpcode::Power:
+                for (size_t i = 0; i < count; i++) pSecond[i] = std::pow(pSecond[i], pTop[i]);
+                depth--;
+                break;
+            case ExpressionOpcode::Negate:
+                for (size_t i = 0; i < count; i++) pTop[i] = -pTop[i];
+                break;
+            case ExpressionOpcode::Sin:
+                for (size_t i = 0; i < count; i++) pTop[i] = std::sin(pTop[i]);
+                break;
+            case ExpressionOpcode::Cos:
+                for (size_t i = 0; i < count; i++) pTop[i] = std::cos(pTop[i]);
+                break;
+            case ExpressionOpcode::Exp:
+                for (size_t i = 0; i < count; i++) pTop[i] = std::exp(pTop[i]);
+                break;
+            case ExpressionOpcode::Log:
+                for (size_t i = 0; i < count; i++) pTop[i] = std::log(pTop[i]);
+                break;
+            case ExpressionOpcode::Sqrt:
+                for (size_t i = 0; i < count; i++) pTop[i] = std::sqrt(pTop[i]);
+                break;
+            }
+        }
+        std::copy(_stack.begin(), _stack.begin() + count, pOutput);
+    }
+
+
+private:
+    std::vector<ExpressionInstruction> _instructions;
+    std::vector<float> _stack;
+};
+
+
+struct ContourGrid
+{
+    float xMin;
+    float xMax;
+    float yMin;
+    float yMax;
+    uint32_t cellsX;
+    uint32_t cellsY;
+};
+
+
+// Marching squares for implicit curves f(x, y) = 0. The grid is split into square blocks which are spread over
+// threads, each block with its own hash table from cell edge to vertex so the two cells sharing an edge share
+// its vertex. The blocks are stitched together by edge afterwards and the segments walked into polylines,
+// which come out in the renderer's float vertex format as y = basis[0], ready to be cut into line strip tiles.
+class ContourExtractor
+{
+public:
+    static const uint32_t blockSize = 32;
+
+    // The calling thread works on the blocks too, so threadCount - 1 workers are started. They wait for the next
+    // extract rather than being started for each one, views change every frame while panning.
+    explicit ContourExtractor(uint32_t threadCount = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        for (uint32_t thread = 1; thread < threadCount; thread++) {
+            _workers.emplace_back([this]() { _runWorker(); });
+        }
+    }
+
+    ContourExtractor(const ContourExtractor&) = delete;
+    ContourExtractor& operator=(const ContourExtractor&) = delete;
+
+    ~ContourExtractor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _workReady.notify_all();
+        for (std::thread& worker : _workers) {
+            worker.join();
+        }
+    }
+
+
+    // "lhs = rhs" becomes lhs - rhs, anything without an '=' is taken as already being f(x, y) = 0.
+    // x and y are real, so complex constants like 2i are rejected rather than silently losing their imaginary part.
+    static std::vector<ExpressionInstruction> compileEquation(const std::string& equation)
+    {
+        size_t equals = equation.find('=');
+        std::string expression = equals == std::string::npos ? equation : "(" + equation.substr(0, equals) + ") - (" + equation.substr(equals + 1) + ")";
+        std::vector<ExpressionInstruction> program = ExpressionCompiler().compile(expression, {"x", "y"});
+        for (const ExpressionInstruction& instruction : program) {
+            if (instruction.opcode == ExpressionOpcode::PushConstant && instruction.value[1] != 0.0f) {
+                throw std::runtime_error("Implicit equation " + equation + " has an imaginary constant, only x and y can be used");
+            }
+        }
+        return program;
+    }
+
+
+    std::vector<std::vector<FunctionVertex>> extract(const std::vector<ExpressionInstruction>& program, const ContourGrid& grid)
+    {
+        uint32_t blocksX = (grid.cellsX + blockSize - 1) / blockSize;
+        uint32_t blocksY = (grid.cellsY + blockSize - 1) / blockSize;
+        std::vector<BlockContour> blocks(blocksX * blocksY);
+        std::atomic<uint32_t> nextBlock{0};
+        std::function<void()> work = [&]() {
+            ExpressionEvaluator evaluator(program);
+            std::vector<float> scratch;
+            for (uint32_t block = nextBlock++; block < blocks.size(); block = nextBlock++) {
+                _extractBlock(evaluator, grid, (block % blocksX) * blockSize, (block / blocksX) * blockSize, &scratch, &blocks[block]);
+            }
+        };
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pWork = &work;
+            _busyWorkerCount = static_cast<uint32_t>(_workers.size());
+            _generation++;
+        }
+        _workReady.notify_all();
+        work();
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _workDone.wait(lock, [this]() { return _busyWorkerCount == 0; });
+            _pWork = nullptr;
+        }
+        _segmentCount = 0;
+        for (const BlockContour& block : blocks) {
+            _segmentCount += block.segments.size();
+        }
+        return _buildPolylines(blocks);
+    }
+
+
+    size_t getSegmentCount() const
+    {
+        return _segmentCount;
+    }
+
+
+private:
+    void _runWorker()
+    {
+        uint64_t generation = 0;
+        while (true) {
+            const std::function<void()>* pWork;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _workReady.wait(lock, [this, generation]() { return _stopping || _generation != generation; });
+                if (_stopping) {
+                    return;
+                }
+                generation = _generation;
+                pWork = _pWork;
+            }
+            (*pWork)();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _busyWorkerCount--;
+            }
+            _workDone.notify_one();
+        }
+    }
+
+
+    struct BlockContour
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<uint64_t> edges; // Which grid edge each vertex lies on, for stitching the blocks together
+        std::vector<std::pair<uint32_t, uint32_t>> segments;
+    };
+
+
+    // Edges are numbered by their lower left grid point, times two, plus one for the vertical ones
+    static uint64_t _edgeKey(const ContourGrid& grid, uint32_t i, uint32_t j, bool vertical)
+    {
+        return (static_cast<uint64_t>(j) * (grid.cellsX + 1) + i) * 2 + (vertical ? 1 : 0);
+    }
+
+
+    void _extractBlock(ExpressionEvaluator& evaluator, const ContourGrid& grid, uint32_t firstI, uint32_t firstJ, std::vector<float>* pScratch, BlockContour* pBlock)
+    {
+        uint32_t cellsX = std::min(blockSize, grid.cellsX - firstI);
+        uint32_t cellsY = std::min(blockSize, grid.cellsY - firstJ);
+        uint32_t pointsX = cellsX + 1;
+        size_t pointCount = static_cast<size_t>(pointsX) * (cellsY + 1);
+        float cellWidth = (grid.xMax - grid.xMin) / grid.cellsX;
+        float cellHeight = (grid.yMax - grid.yMin) / grid.cellsY;
+
+        // The whole block's grid points go through the evaluator in one batch
+        pScratch->resize(3 * pointCount);
+        float* pX = pScratch->data();
+        float* pY = pX + pointCount;
+        float* pValues = pY + pointCount;
+        for (uint32_t j = 0; j <= cellsY; j++) {
+            for (uint32_t i = 0; i < pointsX; i++) {
+                pX[j * pointsX + i] = grid.xMin + (firstI + i) * cellWidth;
+                pY[j * pointsX + i] = grid.yMin + (firstJ + j) * cellHeight;
+            }
+        }
+        const float* variables[2] = {pX, pY};
+        evaluator.evaluate(variables, pointCount, pValues);
+
+        std::unordered_map<uint64_t, uint32_t> edgeVertices;
+        // Corner k of a cell and the two cell edges that meet there. Edges: 0 bottom, 1 right, 2 top, 3 left.
+        static const uint32_t cornerEdges[4][2] = {{3, 0}, {0, 1}, {1, 2}, {2, 3}};
+        for (uint32_t j = 0; j < cellsY; j++) {
+            for (uint32_t i = 0; i < cellsX; i++) {
+                uint32_t corners[4] = {j * pointsX + i, j * pointsX + i + 1, (j + 1) * pointsX + i + 1, (j + 1) * pointsX + i};
+                float values[4];
+                bool isFinite = true;
+                for (uint32_t k = 0; k < 4; k++) {
+                    values[k] = pValues[corners[k]];
+                    isFinite = isFinite && std::isfinite(values[k]);
+                }
+                if (!isFinite) {
+                    continue;
+                }
+
+                uint32_t vertices[4];
+                uint32_t crossingCount = 0;
+                for (uint32_t edge = 0; edge < 4; edge++) {
+                    uint32_t a = edge;
+                    uint32_t b = (edge + 1) % 4;
+                    if ((values[a] > 0.0f) == (values[b] > 0.0f)) {
+                        continue;
+                    }
+                    crossingCount++;
+                    // Bottom and top edges are horizontal, and keyed from their left end so both cells agree
+                    uint32_t gridI = firstI + i + (edge == 1 ? 1 : 0);
+                    uint32_t gridJ = firstJ + j + (edge == 2 ? 1 : 0);
+                    uint64_t key = _edgeKey(grid, gridI, gridJ, edge % 2 == 1);
+                    auto [it, inserted] = edgeVertices.try_emplace(key, static_cast<uint32_t>(pBlock->x.size()));
+                    if (inserted) {
+                        float t = values[a] / (values[a] - values[b]);
+                        pBlock->x.push_back(pX[corners[a]] + t * (pX[corners[b]] - pX[corners[a]]));
+                        pBlock->y.push_back(pY[corners[a]] + t * (pY[corners[b]] - pY[corners[a]]));
+                        pBlock->edges.push_back(key);
+                    }
+                    vertices[edge] = it->second;
+                }
+
+                if (crossingCount == 2) {
+                    uint32_t first = 4;
+                    for (uint32_t edge = 0; edge < 4; edge++) {
+                        if ((values[edge] > 0.0f) != (values[(edge + 1) % 4] > 0.0f)) {
+                            if (first == 4) {
+                                first = edge;
+                            } else {
+                                pBlock->segments.push_back({vertices[first], vertices[edge]});
+                            }
+                        }
+                    }
+                } else if (crossingCount == 4) {
+                    // Saddle, the centre decides which pair of opposite corners is cut off from the other pair
+                    bool centerPositive = (values[0] + values[1] + values[2] + values[3]) > 0.0f;
+                    for (uint32_t k = 0; k < 4; k++) {
+                        if ((values[k] > 0.0f) != centerPositive) {
+                            pBlock->segments.push_back({vertices[cornerEdges[k][0]], vertices[cornerEdges[k][1]]});
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+
+    // Every vertex is on at most two segments, so the curves are open polylines ending at the grid border
+    // (or a gap where the function isn't finite) and closed loops, which repeat their first vertex at the end
+    std::vector<std::vector<FunctionVertex>> _buildPolylines(const std::vector<BlockContour>& blocks)
+    {
+        const uint32_t none = std::numeric_limits<uint32_t>::max();
+        std::unordered_map<uint64_t, uint32_t> edgeVertices;
+        std::vector<FunctionVertex> vertices;
+        std::vector<std::array<uint32_t, 2>> neighbours;
+        for (const BlockContour& block : blocks) {
+            std::vector<uint32_t> globalIndices(block.x.size());
+            for (size_t v = 0; v < block.x.size(); v++) {
+                auto [it, inserted] = edgeVertices.try_emplace(block.edges[v], static_cast<uint32_t>(vertices.size()));
+                if (inserted) {
+                    vertices.push_back({block.x[v], {block.y[v], 0.0f, 0.0f, 0.0f}});
+                    neighbours.push_back({none, none});
+                }
+                globalIndices[v] = it->second;
+            }
+            for (const auto& [a, b] : block.segments) {
+                uint32_t globalA = globalIndices[a];
+                uint32_t globalB = globalIndices[b];
+                neighbours[globalA][neighbours[globalA][0] == none ? 0 : 1] = globalB;
+                neighbours[globalB][neighbours[globalB][0] == none ? 0 : 1] = globalA;
+            }
+        }
+
+        std::vector<std::vector<FunctionVertex>> polylines;
+        std::vector<bool> visited(vertices.size(), false);
+        auto walk = [&](uint32_t start) {
+            std::vector<FunctionVertex>& polyline = polylines.emplace_back();
+            uint32_t previous = none;
+            uint32_t current = start;
+            while (current != none && !visited[current]) {
+                visited[current] = true;
+                polyline.push_back(vertices[current]);
+                uint32_t next = neighbours[current][0] != previous ? neighbours[current][0] : neighbours[current][1];
+                previous = current;
+                current = next;
+            }
+            if (current == start) {
+                polyline.push_back(vertices[start]);
+            }
+        };
+        // Open ends first so those polylines are walked from one end rather than split in the middle
+        for (uint32_t v = 0; v < vertices.size(); v++) {
+            if (!visited[v] && neighbours[v][0] != none && neighbours[v][1] == none) {
+                walk(v);
+            }
+        }
+        for (uint32_t v = 0; v < vertices.size(); v++) {
+            if (!visited[v] && neighbours[v][0] != none) {
+                walk(v);
+            }
+        }
+        return polylines;
+    }
+
+
+private:
+    size_t _segmentCount = 0;
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _workReady;
+    std::condition_variable _workDone;
+    const std::function<void()>* _pWork = nullptr;
+    uint64_t _generation = 0;
+    uint32_t _busyWorkerCount = 0;
+    bool _stopping = false;
+};
+
+
+// A glyph's quad relative to the start of its label's baseline, in pixels with y up
+struct LaidOutGlyph
+{
+    float offset[2];
+    float size[2];
+    float uvRect[4];
+};
+
+
+struct TextLayout
+{
+    std::vector<LaidOutGlyph> glyphs;
+    float width;
+    float height;
+};
+
+
+// Signed distance field atlas of a small built in 5x7 pixel font, which only has what tick labels need.
+// The glyphs are rasterised once at startup, each in its own cell with enough padding for the distance to fall
+// off, so the text shader can draw them at any size with sharp edges and an outline. Laid out strings are cached
+// by their text, tick labels keep coming back as the view moves.
+class GlyphAtlas
+{
+public:
+    static constexpr const char* characters = "0123456789.-+e";
+    static const uint32_t fontWidth = 5;
+    static const uint32_t fontHeight = 7;
+    static const uint32_t texelsPerFontPixel = 3;
+    static const uint32_t cellSize = 32;
+    static const uint32_t cellsPerRow = 8;
+    static const uint32_t distanceSpread = 4; // Texels either side of the edge that the distance covers
+    static constexpr float pixelsPerTexel = 0.5f;
+    static const size_t maxCachedLayouts = 1024;
+
+    // A solid block after the last character, for tick marks
+    void build()
+    {
+        uint32_t cellCount = static_cast<uint32_t>(std::strlen(characters)) + 1;
+        _width = cellsPerRow * cellSize;
+        _height = (cellCount + cellsPerRow - 1) / cellsPerRow * cellSize;
+        _pixels.assign(_width * _height, 0);
+
+        std::vector<bool> inside(cellSize * cellSize);
+        for (uint32_t cell = 0; cell < cellCount; cell++) {
+            for (uint32_t y = 0; y < cellSize; y++) {
+                for (uint32_t x = 0; x < cellSize; x++) {
+                    inside[y * cellSize + x] = _isInside(cell, x, y);
+                }
+            }
+
+            // Brute force over the spread is plenty for a few cells that are only built once
+            uint32_t cellX = cell % cellsPerRow * cellSize;
+            uint32_t cellY = cell / cellsPerRow * cellSize;
+            const int32_t spread = static_cast<int32_t>(distanceSpread);
+            for (int32_t y = 0; y < static_cast<int32_t>(cellSize); y++) {
+                for (int32_t x = 0; x < static_cast<int32_t>(cellSize); x++) {
+                    bool isInside = inside[y * cellSize + x];
+                    int32_t nearestSquared = (spread + 1) * (spread + 1);
+                    for (int32_t dy = -spread; dy <= spread; dy++) {
+                        for (int32_t dx = -spread; dx <= spread; dx++) {
+                            int32_t otherX = x + dx;
+                            int32_t otherY = y + dy;
+                            bool otherInside = otherX >= 0 && otherY >= 0 && otherX < static_cast<int32_t>(cellSize) && otherY < static_cast<int32_t>(cellSize) && inside[otherY * cellSize + otherX];
+                            if (otherInside != isInside) {
+                                nearestSquared = std::min(nearestSquared, dx * dx + dy * dy);
+                            }
+                        }
+                    }
+                    // The edge lies half way between a texel and its nearest neighbour on the other side
+                    float distance = std::sqrt(static_cast<float>(nearestSquared)) - 0.5f;
+                    float value = 0.5f + (isInside ? distance : -distance) / (2.0f * distanceSpread);
+                    _pixels[(cellY + y) * _width + cellX + x] = static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+                }
+            }
+        }
+        _solidUvRect = _getCellUvRect(cellCount - 1);
+        // Well inside the block, so a quad of any size is solid right up to its edges
+        float centerU = 0.5f * (_solidUvRect[0] + _solidUvRect[2]);
+        float centerV = 0.5f * (_solidUvRect[1] + _solidUvRect[3]);
+        _solidUvRect = {centerU, centerV, centerU, centerV};
+    }
+
+
+    // The least recently used layout goes once there are maxCachedLayouts, so zooming through every order of
+    // magnitude doesn't keep every label ever shown. Returned layouts stay valid until the next call.
+    const TextLayout& layout(const std::string& text)
+    {
+        auto indexIt = _layoutIndex.find(text);
+        if (indexIt != _layoutIndex.end()) {
+            _layouts.splice(_layouts.begin(), _layouts, indexIt->second);
+            return indexIt->second->second;
+        }
+        if (_layouts.size() == maxCachedLayouts) {
+            _layoutIndex.erase(_layouts.back().first);
+            _layouts.pop_back();
+        }
+        _layouts.emplace_front(text, TextLayout{});
+        _layoutIndex[text] = _layouts.begin();
+        _layoutCount++;
+        TextLayout& layout = _layouts.front().second;
+        const float fontPixel = texelsPerFontPixel * pixelsPerTexel;
+        const float advance = (fontWidth + 1) * fontPixel;
+        for (size_t i = 0; i < text.size(); i++) {
+            const char* pCharacter = std::strchr(characters, text[i]);
+            if (pCharacter == nullptr || text[i] == '\0') {
+                continue;
+            }
+            std::array<float, 4> uvRect = _getCellUvRect(static_cast<uint32_t>(pCharacter - characters));
+            LaidOutGlyph& glyph = layout.glyphs.emplace_back();
+            glyph.offset[0] = i * advance - static_cast<float>(_getPaddingLeft()) * pixelsPerTexel;
+            glyph.offset[1] = -static_cast<float>(_getPaddingBottom()) * pixelsPerTexel;
+            glyph.size[0] = cellSize * pixelsPerTexel;
+            glyph.size[1] = cellSize * pixelsPerTexel;
+            std::copy(uvRect.begin(), uvRect.end(), glyph.uvRect);
+        }
+        layout.width = text.empty() ? 0.0f : text.size() * advance - fontPixel;
+        layout.height = fontHeight * fontPixel;
+        return layout;
+    }
+
+
+    const std::vector<uint8_t>& getPixels() const
+    {
+        return _pixels;
+    }
+
+
+    uint32_t getWidth() const
+    {
+        return _width;
+    }
+
+
+    uint32_t getHeight() const
+    {
+        return _height;
+    }
+
+
+    const std::array<float, 4>& getSolidUvRect() const
+    {
+        return _solidUvRect;
+    }
+
+
+    // How many distinct strings have been laid out, the rest came from the cache
+    size_t getLayoutCount() const
+    {
+        return _layoutCount;
+    }
+
+
+private:
+    static uint32_t _getPaddingLeft()
+    {
+        return (cellSize - fontWidth * texelsPerFontPixel) / 2;
+    }
+
+
+    static uint32_t _getPaddingTop()
+    {
+        return (cellSize - fontHeight * texelsPerFontPixel) / 2;
+    }
+
+
+    static uint32_t _getPaddingBottom()
+    {
+        return cellSize - fontHeight * texelsPerFontPixel - _getPaddingTop();
+    }
+
+
+    // x and y are texels within the cell, y going down
+    static bool _isInside(uint32_t cell, uint32_t x, uint32_t y)
+    {
+        // One byte per row, top row first, the lowest 5 bits with the leftmost pixel highest
+        static const uint8_t rows[][fontHeight] = {
+            {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // 0
+            {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 1
+            {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // 2
+            {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // 3
+            {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // 4
+            {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // 5
+            {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // 6
+            {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // 7
+            {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // 8
+            {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // 9
+            {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // .
+            {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // -
+            {0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00}, // +
+            {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E}, // e
+            {0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F}  // Solid block
+        };
+        if (x < _getPaddingLeft() || y < _getPaddingTop()) {
+            return false;
+        }
+        uint32_t fontX = (x - _getPaddingLeft()) / texelsPerFontPixel;
+        uint32_t fontY = (y - _getPaddingTop()) / texelsPerFontPixel;
+        if (fontX >= fontWidth || fontY >= fontHeight) {
+            return false;
+        }
+        return (rows[cell][fontY] >> (fontWidth - 1 - fontX)) & 1;
+    }
+
+
+    std::array<float, 4> _getCellUvRect(uint32_t cell) const
+    {
+        float cellX = static_cast<float>(cell % cellsPerRow * cellSize);
+        float cellY = static_cast<float>(cell / cellsPerRow * cellSize);
+        return {cellX / _width, cellY / _height, (cellX + cellSize) / _width, (cellY + cellSize) / _height};
+    }
+
+
+private:
+    std::vector<uint8_t> _pixels;
+    uint32_t _width = 0;
+    uint32_t _height = 0;
+    std::array<float, 4> _solidUvRect = {};
+    std::list<std::pair<std::string, TextLayout>> _layouts; // Most recently used first
+    std::unordered_map<std::string, std::list<std::pair<std::string, TextLayout>>::iterator> _layoutIndex;
+    size_t _layoutCount = 0;
+};
+
+
+// The ticks a view shows on each axis, as a step and the first and last multiple of it in the view.
+// Labels only get rebuilt when this changes, not every time the view moves.
+struct AxisTicks
+{
+    double step[2];
+    int64_t first[2];
+    int64_t last[2];
+
+    bool operator==(const AxisTicks& other) const = default;
+};
+
+
+// How a render graph pass uses a resource. Each maps to the stages, access and image layout in getRenderGraphAccess.
+enum class RenderGraphUsage
+{
+    TransferWrite,
+    ComputeRead,
+    ComputeWrite,
+    ComputeReadWrite,
+    VertexShaderRead,
+    VertexAttributeRead,
+    IndexRead,
+    IndirectRead,
+    ColorAttachmentWrite,
+    Present
+};
+
+
+struct RenderGraphAccess
+{
+    VkPipelineStageFlags stages;
+    VkAccessFlags access;
+    VkImageLayout layout; // Ignored for buffers
+};
+
+
+inline RenderGraphAccess getRenderGraphAccess(RenderGraphUsage usage)
+{
+    switch (usage) {
+    case RenderGraphUsage::TransferWrite:
+        return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+    case RenderGraphUsage::ComputeRead:
+        return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL};
+    case RenderGraphUsage::ComputeWrite:
+        return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL};
+    case RenderGraphUsage::ComputeReadWrite:
+        return {VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL};
+    case RenderGraphUsage::VertexShaderRead:
+        return {VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL};
+    case RenderGraphUsage::VertexAttributeRead:
+        return {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+    case RenderGraphUsage::IndexRead:
+        return {VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+    case RenderGraphUsage::IndirectRead:
+        return {VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+    case RenderGraphUsage::ColorAttachmentWrite:
+        return {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    case RenderGraphUsage::Present:
+        return {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+    }
+    throw std::runtime_error("Unknown render graph usage");
+}
+
+
+// The queues a render graph's passes can go on, in the order they're submitted. A queue can only wait on the
+// ones before it, so within a frame work can only be handed on down this list.
+enum class RenderGraphQueue : uint32_t
+{
+    Transfer,
+    Compute,
+    Graphics,
+    Count
+};
+
+
+inline const char* getRenderGraphQueueName(RenderGraphQueue queue)
+{
+    const char* names[] = {"transfer", "compute", "graphics"};
+    return names[static_cast<size_t>(queue)];
+}
+
+
+// Device local memory for render graphs' transient buffers, kept from frame to frame so a frame normally reuses
+// the buffers the one before made. Buffers are made shared between all the queue families passed in, so they
+// don't need ownership transfers when the graph hands them between queues.
+class RenderGraphTransientMemory
+{
+public:
+    void initialise(VkDevice device, VkPhysicalDevice physicalDevice, const std::vector<uint32_t>& queueFamilies)
+    {
+        _device = device;
+        _physicalDevice = physicalDevice;
+        _queueFamilies = queueFamilies;
+    }
+
+
+    void destroy()
+    {
+        for (const auto& [key, cachedBuffer] : _buffers) {
+            vkDestroyBuffer(_device, cachedBuffer.buffer, nullptr);
+        }
+        _buffers.clear();
+        if (_memory != VK_NULL_HANDLE) {
+            vkFreeMemory(_device, _memory, nullptr);
+            _memory = VK_NULL_HANDLE;
+        }
+        _size = 0;
+    }
+
+
+    // Found with a throwaway buffer, since a buffer can only ever be bound to the one place in memory
+    VkMemoryRequirements getRequirements(VkDeviceSize size, VkBufferUsageFlags usage)
+    {
+        auto it = _requirements.find({size, usage});
+        if (it != _requirements.end()) {
+            return it->second;
+        }
+        VkBuffer buffer = _createBuffer(size, usage);
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(_device, buffer, &requirements);
+        vkDestroyBuffer(_device, buffer, nullptr);
+        _requirements[{size, usage}] = requirements;
+        return requirements;
+    }
+
+
+    // Only called between frames, once the GPU is done with the last one. Buffers the last frame didn't use are
+    // destroyed, and if the memory has to grow every buffer goes with the old memory.
+    void beginFrame(VkDeviceSize size, uint32_t memoryTypeBits)
+    {
+        for (auto it = _buffers.begin(); it != _buffers.end();) {
+            if (!it->second.used) {
+                vkDestroyBuffer(_device, it->second.buffer, nullptr);
+                it = _buffers.erase(it);
+            } else {
+                it->second.used = false;
+                it++;
+            }
+        }
+        if (size <= _size && (memoryTypeBits & (1u << _memoryTypeIndex)) != 0) {
+            return;
+        }
+        destroy();
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(_physicalDevice, &memoryProperties);
+        std::optional<uint32_t> memoryTypeIndex;
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount && !memoryTypeIndex.has_value(); i++) {
+            if ((memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+                memoryTypeIndex = i;
+            }
+        }
+        if (!memoryTypeIndex.has_value()) {
+            throw std::runtime_error("No device local memory type fits the render graph's transient buffers");
+        }
+        VkMemoryAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = size;
+        allocateInfo.memoryTypeIndex = memoryTypeIndex.value();
+        if (vkAllocateMemory(_device, &allocateInfo, nullptr, &_memory) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate render graph transient memory");
+        }
+        _memoryTypeIndex = memoryTypeIndex.value();
+        _size = size;
+    }
+
+
+    VkBuffer getBuffer(VkDeviceSize offset, VkDeviceSize size, VkBufferUsageFlags usage)
+    {
+        CachedBuffer& cachedBuffer = _buffers[{offset, size, usage}];
+        if (cachedBuffer.buffer == VK_NULL_HANDLE) {
+            cachedBuffer.buffer = _createBuffer(size, usage);
+            vkBindBufferMemory(_device, cachedBuffer.buffer, _memory, offset);
+        }
+        cachedBuffer.used = true;
+        return cachedBuffer.buffer;
+    }
+
+
+    VkDeviceSize getSize() const
+    {
+        return _size;
+    }
+
+
+private:
+    VkBuffer _createBuffer(VkDeviceSize size, VkBufferUsageFlags usage)
+    {
+        VkBufferCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        createInfo.size = size;
+        createInfo.usage = usage;
+        createInfo.sharingMode = _queueFamilies.size() > 1 ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+        createInfo.queueFamilyIndexCount = _queueFamilies.size() > 1 ? static_cast<uint32_t>(_queueFamilies.size()) : 0;
+        createInfo.pQueueFamilyIndices = _queueFamilies.data();
+        VkBuffer buffer;
+        if (vkCreateBuffer(_device, &createInfo, nullptr, &buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render graph transient buffer");
+        }
+        return buffer;
+    }
+
+
+private:
+    struct CachedBuffer
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        bool used = false;
+    };
+
+    VkDevice _device = VK_NULL_HANDLE;
+    VkPhysicalDevice _physicalDevice = VK_NULL_HANDLE;
+    std::vector<uint32_t> _queueFamilies;
+    VkDeviceMemory _memory = VK_NULL_HANDLE;
+    VkDeviceSize _size = 0;
+    uint32_t _memoryTypeIndex = 0;
+    std::map<std::pair<VkDeviceSize, VkBufferUsageFlags>, VkMemoryRequirements> _requirements;
+    std::map<std::tuple<VkDeviceSize, VkDeviceSize, VkBufferUsageFlags>, CachedBuffer> _buffers; // By offset, size and usage
+};
+
+
+// A frame's work as a list of passes that say which resources they use and how, and which queue they run on.
+// Compiling it works out exactly the barriers and layout transitions each pass needs: writes are made visible to
+// later reads (once per set of reading stages), later writes wait for earlier reads, and images move to whatever
+// layout the next pass wants. Where a resource goes from one queue to another the later queue waits on the earlier
+// one's semaphore instead, at the stages getWaitStages gives, which also makes the writes visible.
+// Built fresh every frame. With one frame in flight the fence wait covers everything from the previous frame,
+// so resources start out with nothing to wait for unless they're imported with stages to wait on. Buffers the host
+// writes are imported like any other, the submit makes host writes visible, but declaring their reads means a
+// GPU write added later gets ordered after them. Transient buffers only live for the frame, and share memory with
+// each other wherever their passes don't overlap.
+class RenderGraph
+{
+public:
+    using Resource = uint32_t;
+
+    Resource importBuffer(VkBuffer buffer)
+    {
+        ResourceState& state = _resources.emplace_back();
+        state.buffer = buffer;
+        return static_cast<Resource>(_resources.size() - 1);
+    }
+
+
+    // pendingStages are stages whose earlier use the first pass has to wait for, e.g. the stage a swapchain acquire
+    // semaphore is waited on. The image gets transitioned to the final usage's layout at the end of the graph.
+    // Images stay on the graphics queue, there are no queue family ownership transfers for their layouts.
+    Resource importImage(VkImage image, VkImageLayout initialLayout, VkPipelineStageFlags pendingStages, RenderGraphUsage finalUsage)
+    {
+        ResourceState& state = _resources.emplace_back();
+        state.image = image;
+        state.layout = initialLayout;
+        state.readStages[static_cast<size_t>(RenderGraphQueue::Graphics)] = pendingStages;
+        state.finalUsage = finalUsage;
+        return static_cast<Resource>(_resources.size() - 1);
+    }
+
+
+    // Made by compile, out of memory it shares with other transient buffers whose last pass comes before its
+    // first one on the same queue. Its contents start out undefined, so its first use has to write it.
+    Resource createBuffer(VkDeviceSize size, VkBufferUsageFlags usage)
+    {
+        ResourceState& state = _resources.emplace_back();
+        state.transient = Transient{};
+        state.transient->size = size;
+        state.transient->usage = usage;
+        return static_cast<Resource>(_resources.size() - 1);
+    }
+
+
+    void addPass(const std::string& name, const std::vector<std::pair<Resource, RenderGraphUsage>>& uses, std::function<void(VkCommandBuffer)> record, RenderGraphQueue queue = RenderGraphQueue::Graphics)
+    {
+        _passes.push_back({name, uses, std::move(record), queue, {}});
+    }
+
+
+    // Places the transient buffers and works out every pass's barriers and the waits between queues
+    void compile(RenderGraphTransientMemory& memory)
+    {
+        _placeTransientBuffers(memory);
+        for (Pass& pass : _passes) {
+            for (const auto& [resource, usage] : pass.uses) {
+                _use(pass.name, resource, getRenderGraphAccess(usage), pass.queue, pass.barrier);
+            }
+        }
+        for (Resource resource = 0; resource < _resources.size(); resource++) {
+            if (_resources[resource].finalUsage.has_value()) {
+                _use("end of frame", resource, getRenderGraphAccess(*_resources[resource].finalUsage), RenderGraphQueue::Graphics, _finalBarrier);
+            }
+        }
+    }
+
+
+    VkBuffer getBuffer(Resource resource) const
+    {
+        return _resources[resource].buffer;
+    }
+
+
+    bool hasPasses(RenderGraphQueue queue) const
+    {
+        return std::any_of(_passes.begin(), _passes.end(), [queue](const Pass& pass) { return pass.queue == queue; });
+    }
+
+
+    // The stages the queue's submit has to wait for an earlier queue's semaphore at, 0 if it doesn't depend on it
+    VkPipelineStageFlags getWaitStages(RenderGraphQueue queue, RenderGraphQueue earlierQueue) const
+    {
+        return _waitStages[static_cast<size_t>(queue)][static_cast<size_t>(earlierQueue)];
+    }
+
+
+    // Each queue's passes go in their own command buffer, the graphics one finishing with the final transitions
+    void record(RenderGraphQueue queue, VkCommandBuffer commandBuffer) const
+    {
+        for (const Pass& pass : _passes) {
+            if (pass.queue == queue) {
+                _recordBarrier(commandBuffer, pass.barrier);
+                pass.record(commandBuffer);
+            }
+        }
+        if (queue == RenderGraphQueue::Graphics) {
+            _recordBarrier(commandBuffer, _finalBarrier);
+        }
+    }
+
+
+    uint32_t getBarrierCount() const
+    {
+        uint32_t count = _finalBarrier.srcStages != 0 ? 1 : 0;
+        for (const Pass& pass : _passes) {
+            count += pass.barrier.srcStages != 0 ? 1 : 0;
+        }
+        return count;
+    }
+
+
+    // What the transient buffers would take without any aliasing, to compare with the memory's size
+    VkDeviceSize getTransientBufferSize() const
+    {
+        return _transientBufferSize;
+    }
+
+
+private:
+    static const VkAccessFlags _writeAccess = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                              VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    static const size_t _queueCount = static_cast<size_t>(RenderGraphQueue::Count);
+
+    struct Transient
+    {
+        VkDeviceSize size = 0;
+        VkBufferUsageFlags usage = 0;
+        size_t firstPass = 0;
+        size_t lastPass = 0;
+        RenderGraphQueue queue = RenderGraphQueue::Graphics;
+        bool singleQueue = true; // Only buffers used on one queue share memory, other queues' passes can overlap in time
+        VkPipelineStageFlags stages = 0; // Every stage any of its passes use it at
+        VkAccessFlags writeAccess = 0;
+        VkDeviceSize offset = 0;
+        VkDeviceSize memorySize = 0;
+    };
+
+    // Barrier state is only kept on the queue of the last write, the other queues go through their semaphore waits
+    struct ResourceState
+    {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        std::optional<RenderGraphUsage> finalUsage;
+        std::optional<Transient> transient;
+        std::optional<RenderGraphQueue> writeQueue;
+        VkPipelineStageFlags writeStages = 0; // The last write, still to be made visible
+        VkAccessFlags writeAccess = 0;
+        VkPipelineStageFlags readStages[_queueCount] = {}; // Everything reading since the last write, per queue, which the next write has to wait for
+        VkPipelineStageFlags visibleStages = 0; // Where the last write has been made visible already
+        VkAccessFlags visibleAccess = 0;
+    };
+
+    // Everything a pass needs goes into a single vkCmdPipelineBarrier
+    struct Barrier
+    {
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        std::vector<std::pair<Resource, RenderGraphUsage>> uses;
+        std::function<void(VkCommandBuffer)> record;
+        RenderGraphQueue queue;
+        Barrier barrier;
+    };
+
+
+    // Each transient buffer goes at the lowest offset that's clear of every buffer it can't share memory with.
+    // Whatever used that memory before it is over by its first pass, which waits for it like a write after a write.
+    void _placeTransientBuffers(RenderGraphTransientMemory& memory)
+    {
+        std::vector<Resource> transients;
+        for (size_t passIndex = 0; passIndex < _passes.size(); passIndex++) {
+            const Pass& pass = _passes[passIndex];
+            for (const auto& [resource, usage] : pass.uses) {
+                std::optional<Transient>& transient = _resources[resource].transient;
+                if (!transient.has_value()) {
+                    continue;
+                }
+                RenderGraphAccess access = getRenderGraphAccess(usage);
+                if (transient->stages == 0) {
+                    if ((access.access & _writeAccess) == 0) {
+                        throw std::runtime_error("Render graph pass " + pass.name + " reads a transient buffer before anything wrote it");
+                    }
+                    transient->firstPass = passIndex;
+                    transient->queue = pass.queue;
+                    transients.push_back(resource);
+                }
+                transient->lastPass = passIndex;
+                transient->singleQueue = transient->singleQueue && pass.queue == transient->queue;
+                transient->stages |= access.stages;
+                transient->writeAccess |= access.access & _writeAccess;
+            }
+        }
+
+        VkDeviceSize memorySize = 0;
+        uint32_t memoryTypeBits = ~0u;
+        _transientBufferSize = 0;
+        std::vector<Resource> placed;
+        for (Resource resource : transients) {
+            ResourceState& state = _resources[resource];
+            Transient& transient = *state.transient;
+            VkMemoryRequirements requirements = memory.getRequirements(transient.size, transient.usage);
+            memoryTypeBits &= requirements.memoryTypeBits;
+            transient.memorySize = requirements.size;
+
+            auto canAlias = [&transient](const Transient& other) {
+                return transient.singleQueue && other.singleQueue && transient.queue == other.queue &&
+                       (other.lastPass < transient.firstPass || transient.lastPass < other.firstPass);
+            };
+            auto overlaps = [&transient](const Transient& other) {
+                return transient.offset < other.offset + other.memorySize && other.offset < transient.offset + transient.memorySize;
+            };
+            bool moved = true;
+            while (moved) {
+                moved = false;
+                for (Resource other : placed) {
+                    const Transient& otherTransient = *_resources[other].transient;
+                    if (!canAlias(otherTransient) && overlaps(otherTransient)) {
+                        VkDeviceSize end = otherTransient.offset + otherTransient.memorySize;
+                        transient.offset = (end + requirements.alignment - 1) / requirements.alignment * requirements.alignment;
+                        moved = true;
+                    }
+                }
+            }
+            for (Resource other : placed) {
+                const Transient& otherTransient = *_resources[other].transient;
+                if (overlaps(otherTransient)) {
+                    state.writeQueue = transient.queue;
+                    state.writeStages |= otherTransient.stages;
+                    state.writeAccess |= otherTransient.writeAccess;
+                }
+            }
+            placed.push_back(resource);
+            memorySize = std::max(memorySize, transient.offset + transient.memorySize);
+            _transientBufferSize += transient.memorySize;
+        }
+
+        memory.beginFrame(memorySize, memoryTypeBits);
+        for (Resource resource : transients) {
+            const Transient& transient = *_resources[resource].transient;
+            _resources[resource].buffer = memory.getBuffer(transient.offset, transient.size, transient.usage);
+        }
+    }
+
+
+    // A queue can only wait on queues submitted before it, so a resource handed the other way is an error in the graph
+    void _waitForQueue(const std::string& passName, RenderGraphQueue queue, RenderGraphQueue otherQueue, VkPipelineStageFlags stages)
+    {
+        if (otherQueue > queue) {
+            throw std::runtime_error("Render graph pass " + passName + " on the " + getRenderGraphQueueName(queue) + " queue uses a resource after the " +
+                                     getRenderGraphQueueName(otherQueue) + " queue, which is submitted later");
+        }
+        _waitStages[static_cast<size_t>(queue)][static_cast<size_t>(otherQueue)] |= stages;
+    }
+
+
+    void _use(const std::string& passName, Resource resource, const RenderGraphAccess& access, RenderGraphQueue queue, Barrier& barrier)
+    {
+        ResourceState& state = _resources[resource];
+        if (state.image != VK_NULL_HANDLE && queue != RenderGraphQueue::Graphics) {
+            throw std::runtime_error("Render graph pass " + passName + " uses an image off the graphics queue");
+        }
+        size_t queueIndex = static_cast<size_t>(queue);
+        bool isWrite = (access.access & _writeAccess) != 0;
+        bool isLayoutChange = state.image != VK_NULL_HANDLE && access.layout != state.layout;
+        bool isWriteQueue = state.writeQueue == queue;
+        if (state.writeQueue.has_value() && !isWriteQueue) {
+            _waitForQueue(passName, queue, *state.writeQueue, access.stages);
+        }
+
+        if (isWrite || isLayoutChange) {
+            for (size_t otherQueue = 0; otherQueue < _queueCount; otherQueue++) {
+                if (otherQueue != queueIndex && state.readStages[otherQueue] != 0) {
+                    _waitForQueue(passName, queue, static_cast<RenderGraphQueue>(otherQueue), access.stages);
+                }
+            }
+            // Write after write needs a memory dependency, write after read only an execution one
+            VkPipelineStageFlags srcStages = state.readStages[queueIndex] | (isWriteQueue ? state.writeStages : 0);
+            if (srcStages != 0 || isLayoutChange) {
+                _addBarrier(barrier, state, srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, isWriteQueue ? state.writeAccess : 0, access);
+            }
+            // A layout transition counts as a write that's already visible to the stages it was made for
+            state.writeQueue = queue;
+            state.writeStages = isWrite ? access.stages : 0;
+            state.writeAccess = access.access & _writeAccess;
+            std::fill(std::begin(state.readStages), std::end(state.readStages), 0);
+            state.readStages[queueIndex] = isWrite ? 0 : access.stages;
+            state.visibleStages = isWrite ? 0 : access.stages;
+            state.visibleAccess = isWrite ? 0 : access.access;
+            state.layout = access.layout;
+            return;
+        }
+
+        if (isWriteQueue && state.writeAccess != 0 && ((access.stages & ~state.visibleStages) != 0 || (access.access & ~state.visibleAccess) != 0)) {
+            _addBarrier(barrier, state, state.writeStages, state.writeAccess, access);
+            state.visibleStages |= access.stages;
+            state.visibleAccess |= access.access;
+        }
+        state.readStages[queueIndex] |= access.stages;
+    }
+
+
+    void _addBarrier(Barrier& barrier, const ResourceState& state, VkPipelineStageFlags srcStages, VkAccessFlags srcAccess, const RenderGraphAccess& access)
+    {
+        barrier.srcStages |= srcStages;
+        barrier.dstStages |= access.stages;
+        if (state.image != VK_NULL_HANDLE) {
+            VkImageMemoryBarrier& imageBarrier = barrier.imageBarriers.emplace_back();
+            imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageBarrier.srcAccessMask = srcAccess;
+            imageBarrier.dstAccessMask = access.access;
+            imageBarrier.oldLayout = state.layout;
+            imageBarrier.newLayout = access.layout;
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.image = state.image;
+            imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            imageBarrier.subresourceRange.baseMipLevel = 0;
+            imageBarrier.subresourceRange.levelCount = 1;
+            imageBarrier.subresourceRange.baseArrayLayer = 0;
+            imageBarrier.subresourceRange.layerCount = 1;
+        } else if (srcAccess != 0) {
+            VkBufferMemoryBarrier& bufferBarrier = barrier.bufferBarriers.emplace_back();
+            bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            bufferBarrier.srcAccessMask = srcAccess;
+            bufferBarrier.dstAccessMask = access.access;
+            bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.buffer = state.buffer;
+            bufferBarrier.offset = 0;
+            bufferBarrier.size = VK_WHOLE_SIZE;
+        }
+    }
+
+
+    static void _recordBarrier(VkCommandBuffer commandBuffer, const Barrier& barrier)
+    {
+        if (barrier.srcStages == 0) {
+            return;
+        }
+        vkCmdPipelineBarrier(commandBuffer, barrier.srcStages, barrier.dstStages, 0, 0, nullptr,
+                             static_cast<uint32_t>(barrier.bufferBarriers.size()), barrier.bufferBarriers.data(),
+                             static_cast<uint32_t>(barrier.imageBarriers.size()), barrier.imageBarriers.data());
+    }
+
+
+private:
+    std::vector<ResourceState> _resources;
+    std::vector<Pass> _passes;
+    Barrier _finalBarrier;
+    VkPipelineStageFlags _waitStages[_queueCount][_queueCount] = {}; // Indexed by the waiting queue, then the one waited on
+    VkDeviceSize _transientBufferSize = 0;
+};
+
+
+// Runs named steps on a small thread pool as soon as everything they depend on has finished. Steps that have
+// to stay on the calling thread (SDL windows and surfaces, for Cocoa's sake) are marked Thread::Main.
+// Every step is timed so the chain that actually held things up can be printed afterwards.
+class TaskGraph
+{
+public:
+    enum class Thread { Any, Main };
+
+    size_t add(const std::string& name, const std::vector<size_t>& dependencies, std::function<void()> function, Thread thread = Thread::Any)
+    {
+        Task& task = _tasks.emplace_back();
+        task.name = name;
+        task.dependencies = dependencies;
+        task.function = std::move(function);
+        task.thread = thread;
+        return _tasks.size() - 1;
+    }
+
+
+    // Blocks until every step has run, rethrowing the first exception if one of them failed.
+    // Steps depending on a failed one never start.
+    void run(uint32_t workerCount)
+    {
+        _start = std::chrono::steady_clock::now();
+        for (size_t index = 0; index < _tasks.size(); index++) {
+            _tasks[index].remainingDependencies = static_cast<uint32_t>(_tasks[index].dependencies.size());
+            for (size_t dependency : _tasks[index].dependencies) {
+                _tasks[dependency].dependents.push_back(index);
+            }
+        }
+        for (size_t index = 0; index < _tasks.size(); index++) {
+            if (_tasks[index].remainingDependencies == 0) {
+                _readyTasks[static_cast<size_t>(_tasks[index].thread)].push_back(index);
+            }
+        }
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 0; i < workerCount; i++) {
+            workers.emplace_back([this]() { _runTasks(Thread::Any); });
+        }
+        _runTasks(Thread::Main);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        _end = std::chrono::steady_clock::now();
+        if (_error) {
+            std::rethrow_exception(_error);
+        }
+    }
+
+
+    // Walks back from the last step to finish, each time to the dependency that finished last
+    void printCriticalPath() const
+    {
+        std::chrono::steady_clock::duration serialTime{};
+        size_t last = 0;
+        for (size_t index = 0; index < _tasks.size(); index++) {
+            serialTime += _tasks[index].end - _tasks[index].start;
+            if (_tasks[index].end > _tasks[last].end) {
+                last = index;
+            }
+        }
+
+        std::vector<size_t> path = {last};
+        while (!_tasks[path.back()].dependencies.empty()) {
+            const std::vector<size_t>& dependencies = _tasks[path.back()].dependencies;
+            path.push_back(*std::max_element(dependencies.begin(), dependencies.end(), [this](size_t a, size_t b) {
+                return _tasks[a].end < _tasks[b].end;
+            }));
+        }
+
+        std::cout << "Startup took " << std::chrono::duration<double, std::milli>(_end - _start).count() << "ms, "
+                  << std::chrono::duration<double, std::milli>(serialTime).count() << "ms if run serially. Critical path:";
+        for (auto it = path.rbegin(); it != path.rend(); it++) {
+            std::cout << (it == path.rbegin() ? " " : " -> ") << _tasks[*it].name << " ("
+                      << std::chrono::duration<double, std::milli>(_tasks[*it].end - _tasks[*it].start).count() << "ms)";
+        }
+        std::cout << "\n";
+    }
+
+
+private:
+    void _runTasks(Thread thread)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        std::deque<size_t>& readyTasks = _readyTasks[static_cast<size_t>(thread)];
+        while (true) {
+            // Once something failed no more tasks are started, and every thread waits for whatever is still running
+            // before returning, so nothing touches a half built object afterwards
+            _condition.wait(lock, [&]() {
+                return _finishedCount == _tasks.size() || (_error ? _runningCount == 0 : !readyTasks.empty());
+            });
+            if (_finishedCount == _tasks.size() || _error) {
+                return;
+            }
+            size_t index = readyTasks.front();
+            readyTasks.pop_front();
+            _runningCount++;
+            lock.unlock();
+
+            Task& task = _tasks[index];
+            std::exception_ptr error;
+            task.start = std::chrono::steady_clock::now();
+            try {
+                task.function();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            task.end = std::chrono::steady_clock::now();
+
+            lock.lock();
+            _runningCount--;
+            _finishedCount++;
+            if (error && !_error) {
+                _error = error;
+            }
+            for (size_t dependent : task.dependents) {
+                if (--_tasks[dependent].remainingDependencies == 0) {
+                    _readyTasks[static_cast<size_t>(_tasks[dependent].thread)].push_back(dependent);
+                }
+            }
+            _condition.notify_all();
+        }
+    }
+
+
+private:
+    struct Task
+    {
+        std::string name;
+        std::vector<size_t> dependencies;
+        std::vector<size_t> dependents;
+        std::function<void()> function;
+        Thread thread;
+        uint32_t remainingDependencies = 0;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+    };
+
+    std::vector<Task> _tasks;
+    std::deque<size_t> _readyTasks[2]; // Indexed by Thread
+    size_t _finishedCount = 0;
+    size_t _runningCount = 0;
+    std::exception_ptr _error;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::chrono::steady_clock::time_point _start;
+    std::chrono::steady_clock::time_point _end;
+};
+
+
+class HelloTriangleApplication
+{
+private:
+    // One window and everything presenting into it. The device, pipelines, tile pools and plot buffers are shared,
+    // each view only has its own swapchain, view range and part of the draw command and count buffers.
+    struct PlotView
+    {
+        SDL_Window* pWindow = nullptr;
+        VkExtent2D windowPixelSize{}; // Read when the window is made, on the main thread, the swapchain may not be
+        VkSurfaceKHR surface = VK_NULL_HANDLE;
+        VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+        std::vector<VkImage> swapchainImages;
+        VkExtent2D swapchainExtent{};
+        std::vector<VkImageView> swapchainImageViews;
+        std::vector<VkFramebuffer> swapchainFrameBuffers;
+        VkSemaphore imageAvailableSemaphore = VK_NULL_HANDLE;
+        VkSemaphore renderFinishedSemaphore = VK_NULL_HANDLE;
+        uint32_t imageIndex = 0;
+        float viewRange[4] = {-2.0f, 2.0f, -2.0f, 2.0f}; // xMin, xMax, yMin, yMax
+        int32_t tileLevel = 0;
+        std::optional<AxisTicks> builtTicks; // What the view's part of the glyph instance buffer was built for
+        uint32_t glyphInstanceCount = 0;
+    };
+
+
+public:
+    // Data files are loaded once Vulkan is up, see DataPlotSource for the format
+    void addDataFile(const std::string& path)
+    {
+        _dataFilePaths.push_back(path);
+    }
+
+
+    // Implicit curves like "x^2 + y^2 = 1" are contoured on the CPU, see ContourExtractor
+    void addImplicitEquation(const std::string& equation)
+    {
+        _pendingImplicitEquations.push_back(equation);
+    }
+
+
+    // Instead of the interactive loop, times functionCount functions in each vertex format in turn, then exits
+    void setFormatBenchmark(uint32_t functionCount)
+    {
+        _formatBenchmarkFunctionCount = functionCount;
+    }
+
+
+    void run()
+    {
+        _initialise();
+        if (_formatBenchmarkFunctionCount > 0) {
+            _runFormatBenchmark();
+        } else {
+            _mainLoop();
+        }
+        _cleanup();
+    }
+
+
+private:
+    void _initSdl()
+    {
+        if (!SDL_Init(SDL_INIT_VIDEO)) {
+            throw std::runtime_error("Could not initialise SDL");
+        }
+        // Loaded up front rather than by SDL_CreateWindow, since the instance gets created alongside the window
+        if (!SDL_Vulkan_LoadLibrary(nullptr)) {
+            throw std::runtime_error("Could not load the Vulkan library");
+        }
+    }
+
+
+    void _createWindow(PlotView& view)
+    {
+        std::string title = _views.size() == 1 ? "Vulkan lab copied implementation" : "Vulkan lab view " + std::to_string(_views.size());
+        view.pWindow = SDL_CreateWindow(title.c_str(), _windowWidth, _windowHeight, SDL_WINDOW_VULKAN);
+        if (!view.pWindow) {
+            throw std::runtime_error("Could not create SDL window");
+        }
+        int width, height;
+        SDL_GetWindowSizeInPixels(view.pWindow, &width, &height);
+        view.windowPixelSize = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+    }
+
+
+    // Each step only waits for what it actually uses, so the shaders get loaded and the pipelines compiled
+    // while the swapchain is being made, and the window is created while the instance is.
+    // Steps that allocate from the command pool or use the queue are chained, since those aren't thread safe.
+    void _initialise()
+    {
+        TaskGraph graph;
+        using Thread = TaskGraph::Thread;
+        size_t sdl = graph.add("SDL", {}, [this]() { _initSdl(); }, Thread::Main);
+        _views.emplace_back();
+        size_t window = graph.add("window", {sdl}, [this]() { _createWindow(_views[0]); }, Thread::Main);
+        size_t shaderCode = graph.add("load SPIR-V", {}, [this]() { _loadShaderCode(); });
+        size_t instance = graph.add("instance", {sdl}, [this]() { _createInstance(); });
+        graph.add("debug messenger", {instance}, [this]() { _setupDebugMessenger(); });
+        size_t surface = graph.add("surface", {instance, window}, [this]() { _createSurface(_views[0]); }, Thread::Main);
+        size_t physicalDevice = graph.add("physical device", {surface}, [this]() { _pickPhysicalDevice(); _chooseSurfaceFormat(); });
+        size_t device = graph.add("logical device", {physicalDevice}, [this]() { _createLogicalDevice(); });
+
+        size_t swapchain = graph.add("swapchain", {device}, [this]() { _createSwapChain(_views[0]); });
+        size_t imageViews = graph.add("image views", {swapchain}, [this]() { _createImageViews(_views[0]); });
+        size_t renderPass = graph.add("render pass", {device}, [this]() { _createRenderPass(); });
+        graph.add("framebuffers", {imageViews, renderPass}, [this]() { _createFrameBuffers(_views[0]); });
+
+        size_t shaderModules = graph.add("shader modules", {device, shaderCode}, [this]() { _createShaderModules(); });
+        size_t descriptorSetLayout = graph.add("descriptor set layout", {device}, [this]() { _createDescriptorSetLayout(); });
+        size_t pipelineLayout = graph.add("pipeline layout", {descriptorSetLayout}, [this]() { _createPipelineLayout(); });
+        size_t plotPipelines = graph.add("plot pipelines", {renderPass, pipelineLayout, shaderModules}, [this]() { _createGraphicsPipeline(); });
+        size_t domainColoringPipeline = graph.add("domain coloring pipeline", {renderPass, pipelineLayout, shaderModules}, [this]() { _createDomainColoringPipeline(); });
+        size_t cullPipeline = graph.add("cull pipeline", {descriptorSetLayout, shaderModules}, [this]() { _createCullPipeline(); });
+        size_t textPipeline = graph.add("text pipeline", {renderPass, pipelineLayout, shaderModules}, [this]() { _createTextPipeline(); });
+        graph.add("destroy shader modules", {plotPipelines, domainColoringPipeline, cullPipeline, textPipeline}, [this]() { _destroyShaderModules(); });
+
+        size_t commandPool = graph.add("command pool", {device}, [this]() { _createCommandPool(); });
+        size_t commandBuffer = graph.add("command buffer", {commandPool}, [this]() { _createCommandBuffer(); });
+        size_t tilePools = graph.add("tile pools", {device}, [this]() { _createTilePools(); });
+        size_t plotBuffers = graph.add("plot buffers", {commandBuffer}, [this]() { _createPlotBuffers(); });
+        size_t expressionBuffer = graph.add("expression buffer", {device}, [this]() { _createExpressionBuffer(); });
+        size_t glyphs = graph.add("rasterise glyphs", {}, [this]() { _glyphAtlas.build(); });
+        // After the plot buffers, since both upload through the command pool and the graphics queue
+        size_t glyphAtlas = graph.add("glyph atlas", {glyphs, plotBuffers}, [this]() { _createGlyphAtlasImage(); });
+        size_t glyphInstanceBuffer = graph.add("glyph instance buffer", {device}, [this]() { _createGlyphInstanceBuffer(); });
+        size_t descriptorPool = graph.add("descriptor pool", {device}, [this]() { _createDescriptorPool(); });
+        graph.add("descriptor set", {descriptorPool, descriptorSetLayout, plotBuffers, expressionBuffer, glyphAtlas, glyphInstanceBuffer}, [this]() { _createDescriptorSet(); });
+        graph.add("timestamp query pool", {device}, [this]() { _createTimestampQueryPool(); });
+        graph.add("sync objects", {device}, [this]() { _createSyncObjects(); _createViewSemaphores(_views[0]); });
+        graph.add("plot functions", {tilePools, plotBuffers, swapchain}, [this]() { _initPlotFunctions(); });
+
+        graph.run(std::clamp(std::thread::hardware_concurrency(), 1u, 4u));
+        graph.printCriticalPath();
+    }
+
+
+    void _initPlotFunctions()
+    {
+        // ax^2 + bx + c
+        _quadratic.setTerms({
+            [](float x) { return x * x; },
+            [](float x) { return x; },
+            [](float x) { return 1.0f; }
+        });
+        _quadratic.setCoefficient(0, 1.0f);
+        _quadratic.setCoefficient(1, 0.0f);
+        _quadratic.setCoefficient(2, -1.0f);
+        _plotFunctions.push_back(&_quadratic);
+        _pendingDomainExpression = _domainExpressions[0];
+
+        for (const std::string& path : _dataFilePaths) {
+            _addDataPlot(path);
+        }
+        for (const std::string& equation : _pendingImplicitEquations) {
+            _addImplicitPlot(equation);
+        }
+    }
+
+
+    // Data plots own their tile slots and function data entries for their whole lifetime, implicit plots their
+    // function data entries. The slots come from the float pool's reserved region past the function tiles, so they
+    // never eat into the room every function needs to be visible. Their function indices come from a fixed region past
+    // the _maxPlotFunctions that stress test functions can use, so the two never collide.
+    std::vector<uint32_t> _reserveTileSlots(uint32_t count, const std::string& name)
+    {
+        if (_freeReservedTileSlots.size() < count) {
+            throw std::runtime_error("Not enough reserved plot tile slots left for " + name);
+        }
+        PlotTilePool& pool = _tilePools[static_cast<size_t>(PlotVertexFormat::Float32)];
+        std::vector<uint32_t> slots;
+        for (uint32_t i = 0; i < count; i++) {
+            slots.push_back(*_freeReservedTileSlots.begin());
+            _freeReservedTileSlots.erase(_freeReservedTileSlots.begin());
+            _useTileSlot(pool, slots.back());
+        }
+        return slots;
+    }
+
+
+    uint32_t _reserveFunctionIndex(float red, float green, float blue)
+    {
+        if (_reservedFunctionCount == _maxReservedFunctions) {
+            throw std::runtime_error("Too many data and implicit plots, at most " + std::to_string(_maxReservedFunctions) + " are supported");
+        }
+        uint32_t functionIndex = _maxPlotFunctions + _reservedFunctionCount++;
+        GpuPlotFunction& gpuFunction = _pFunctionData[functionIndex];
+        gpuFunction = GpuPlotFunction{};
+        gpuFunction.coefficients[0] = 1.0f;
+        gpuFunction.color[0] = red;
+        gpuFunction.color[1] = green;
+        gpuFunction.color[2] = blue;
+        gpuFunction.color[3] = 1.0f;
+        return functionIndex;
+    }
+
+
+    // Data plots draw through the float tile pool like any function, as y = 1 * basis[0]. Their slots are
+    // taken out of the pool for good, enough for two vertices per pixel across the window, so zooming never
+    // needs more GPU memory however big the file is. They follow the first view's x range.
+    void _addDataPlot(const std::string& path)
+    {
+        DataPlot& plot = _dataPlots.emplace_back();
+        plot.source.open(path);
+
+        const uint32_t verticesPerTile = _tileSampleCount - 1;
+        uint32_t tileCount = (2 * _views[0].swapchainExtent.width + verticesPerTile - 1) / verticesPerTile + 1;
+        plot.slots = _reserveTileSlots(tileCount, "data file " + path);
+        plot.functionIndex = _reserveFunctionIndex(1.0f, 0.6f, 0.1f);
+    }
+
+
+    // Implicit plots are drawn the same way as data plots, from polylines contoured over the first view at
+    // about two pixels per grid cell whenever its range changes. How many tiles that takes depends on the curve,
+    // so their slots are taken from the reserved region as each contour needs them.
+    void _addImplicitPlot(const std::string& equation)
+    {
+        // Compiled and given its function index first, so a bad equation doesn't leave a half made plot behind
+        std::vector<ExpressionInstruction> program = ContourExtractor::compileEquation(equation);
+        uint32_t functionIndex = _reserveFunctionIndex(0.3f, 0.9f, 0.4f);
+        ImplicitPlot& plot = _implicitPlots.emplace_back();
+        plot.equation = equation;
+        plot.program = std::move(program);
+        plot.functionIndex = functionIndex;
+        std::cout << "Implicit plot: " << equation << "\n";
+    }
+
+
+    // I adds an implicit plot the first time and then cycles the first one through the example equations
+    void _cycleImplicitEquation()
+    {
+        _implicitEquationIndex = (_implicitEquationIndex + 1) % _implicitEquations.size();
+        if (_implicitPlots.empty()) {
+            _addImplicitPlot(_implicitEquations[_implicitEquationIndex]);
+            return;
+        }
+        ImplicitPlot& plot = _implicitPlots.front();
+        plot.program = ContourExtractor::compileEquation(_implicitEquations[_implicitEquationIndex]);
+        plot.equation = _implicitEquations[_implicitEquationIndex];
+        plot.builtViewRange.reset();
+        std::cout << "Implicit plot: " << plot.equation << "\n";
+    }
+
+
+    // Stress test for the GPU driven path, M adds a batch of randomly shifted parabolas and K fills up to 1000 functions
+    void _addStressTestFunctions(uint32_t count)
+    {
+        for (uint32_t i = 0; i < count && _plotFunctions.size() < _maxPlotFunctions; i++) {
+            PlotFunction& function = _stressTestFunctions.emplace_back();
+            function.setTerms({
+                [](float x) { return x * x; },
+                [](float x) { return x; },
+                [](float x) { return 1.0f; }
+            });
+            function.setCoefficient(0, static_cast<float>(std::rand()) / RAND_MAX * 2.0f - 1.0f);
+            function.setCoefficient(1, static_cast<float>(std::rand()) / RAND_MAX * 2.0f - 1.0f);
+            function.setCoefficient(2, static_cast<float>(std::rand()) / RAND_MAX * 4.0f - 2.0f);
+            function.setColor(static_cast<float>(std::rand()) / RAND_MAX, static_cast<float>(std::rand()) / RAND_MAX, 1.0f);
+            _plotFunctions.push_back(&function);
+        }
+        std::cout << "Plot functions: " << _plotFunctions.size() << "\n";
+    }
+
+
+    // Every function is switched to the format being measured, which re-encodes all the visible tiles in the first
+    // frame (timed around the encoding alone, not the evaluation or the rest of the frame), then the view is left
+    // alone so the frames after that only draw. Vertices per second drawn are the resident ones (all of them
+    // visible, since the view doesn't move) over the plot GPU time.
+    void _runFormatBenchmark()
+    {
+        const uint32_t warmupFrameCount = 30;
+        const uint32_t frameCount = 300;
+        _addStressTestFunctions(_formatBenchmarkFunctionCount);
+        for (uint32_t format = 0; format < static_cast<uint32_t>(PlotVertexFormat::Count); format++) {
+            _quadratic.setVertexFormat(static_cast<PlotVertexFormat>(format));
+            for (PlotFunction& function : _stressTestFunctions) {
+                function.setVertexFormat(static_cast<PlotVertexFormat>(format));
+            }
+            _tileEncodeTime = {};
+            _tileEncodeVertexCount = 0;
+            _drawFrame();
+            double encodeSeconds = std::chrono::duration<double>(_tileEncodeTime).count();
+            uint64_t encodedVertexCount = _tileEncodeVertexCount;
+
+            std::chrono::steady_clock::time_point start;
+            double gpuMicroseconds = 0.0;
+            for (uint32_t frame = 0; frame < warmupFrameCount + frameCount; frame++) {
+                SDL_PumpEvents();
+                if (frame == warmupFrameCount) {
+                    gpuMicroseconds = 0.0;
+                    start = std::chrono::steady_clock::now();
+                }
+                _drawFrame();
+                gpuMicroseconds += _lastPlotGpuMicroseconds; // The previous frame's, read once its fence was waited on
+            }
+            vkDeviceWaitIdle(_device);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            uint64_t tileCount = std::count_if(_residentTiles.begin(), _residentTiles.end(), [format](const auto& entry) {
+                return entry.second.format == static_cast<PlotVertexFormat>(format);
+            });
+            uint64_t vertexCount = tileCount * _tileSampleCount;
+            VkDeviceSize byteCount = vertexCount * _tilePools[format].vertexSize;
+            std::cout << (format == static_cast<uint32_t>(PlotVertexFormat::Float32) ? "Float32" : "Packed16")
+                      << " | " << _plotFunctions.size() << " functions | " << tileCount << " tiles | " << vertexCount << " vertices | "
+                      << byteCount / 1024 << " KiB (" << _tilePools[format].vertexSize << " bytes per vertex) | encoded in "
+                      << encodeSeconds * 1000.0 << "ms, " << encodedVertexCount / encodeSeconds / 1e6 << " Mvertices/s | "
+                      << frameCount / seconds << " frames/s";
+            if (_timestampsSupported) {
+                std::cout << " | " << gpuMicroseconds / frameCount << "us plot GPU time, "
+                          << static_cast<double>(vertexCount) * frameCount / (gpuMicroseconds / 1e6) / 1e6 << " Mvertices/s drawn\n";
+            } else {
+                std::cout << " | no GPU timestamps\n";
+            }
+        }
+    }
+
+
+    void _mainLoop()
+    {
+        SDL_Event event;
+        while (_isRunning) {
+            while (SDL_PollEvent(&event)) {
+                switch (event.type)
+                {
+                case SDL_EVENT_QUIT:
+                    _isRunning = false;
+                    break;
+
+                case SDL_EVENT_WINDOW_CLOSE_REQUESTED:
+                    _closeView(event.window.windowID);
+                    break;
+
+                case SDL_EVENT_KEY_DOWN:
+                    if (PlotView* pView = _findView(event.key.windowID)) {
+                        _handleKeyDown(event.key.key, *pView);
+                    }
+                    break;
+
+                case SDL_EVENT_MOUSE_WHEEL:
+                    if (PlotView* pView = _findView(event.wheel.windowID)) {
+                        _zoomView(event.wheel.y > 0 ? 0.9f : 1.1f, *pView);
+                    }
+                    break;
+                
+                default:
+                    break;
+                }
+            }
+            _drawFrame();
+            SDL_Delay(16);
+        }
+        vkDeviceWaitIdle(_device);
+    }
+
+
+    // Panning and zooming only move the view whose window has focus
+    void _handleKeyDown(SDL_Keycode key, PlotView& view)
+    {
+        float panStep = 0.05f * (view.viewRange[1] - view.viewRange[0]);
+        switch (key)
+        {
+        // Up/Down act as a slider for 'a'. That's only a push constant change, nothing gets re-meshed.
+        case SDLK_UP:
+            _quadratic.setCoefficient(0, _quadratic.getCoefficient(0) + 0.05f);
+            break;
+
+        case SDLK_DOWN:
+            _quadratic.setCoefficient(0, _quadratic.getCoefficient(0) - 0.05f);
+            break;
+
+        // Flips the quadratic between the float and packed vertex formats to compare them in the stats output
+        case SDLK_F:
+            _quadratic.setVertexFormat(_quadratic.getVertexFormat() == PlotVertexFormat::Float32 ? PlotVertexFormat::Packed16 : PlotVertexFormat::Float32);
+            break;
+
+        case SDLK_D:
+            _domainColoringEnabled = !_domainColoringEnabled;
+            break;
+
+        case SDLK_E:
+            _domainExpressionIndex = (_domainExpressionIndex + 1) % _domainExpressions.size();
+            _pendingDomainExpression = _domainExpressions[_domainExpressionIndex];
+            break;
+
+        case SDLK_M:
+            _addStressTestFunctions(100);
+            break;
+
+        case SDLK_K:
+            _addStressTestFunctions(1000 - std::min<uint32_t>(1000, static_cast<uint32_t>(_plotFunctions.size())));
+            break;
+
+        case SDLK_N:
+            _addView();
+            break;
+
+        case SDLK_I:
+            _cycleImplicitEquation();
+            break;
+
+        case SDLK_LEFT:
+            view.viewRange[0] -= panStep;
+            view.viewRange[1] -= panStep;
+            break;
+
+        case SDLK_RIGHT:
+            view.viewRange[0] += panStep;
+            view.viewRange[1] += panStep;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+
+    void _zoomView(float factor, PlotView& view)
+    {
+        float centerX = 0.5f * (view.viewRange[0] + view.viewRange[1]);
+        float centerY = 0.5f * (view.viewRange[2] + view.viewRange[3]);
+        float halfWidth = 0.5f * (view.viewRange[1] - view.viewRange[0]) * factor;
+        float halfHeight = 0.5f * (view.viewRange[3] - view.viewRange[2]) * factor;
+        view.viewRange[0] = centerX - halfWidth;
+        view.viewRange[1] = centerX + halfWidth;
+        view.viewRange[2] = centerY - halfHeight;
+        view.viewRange[3] = centerY + halfHeight;
+    }
+
+
+    PlotView* _findView(SDL_WindowID windowId)
+    {
+        for (PlotView& view : _views) {
+            if (SDL_GetWindowID(view.pWindow) == windowId) {
+                return &view;
+            }
+        }
+        return nullptr;
+    }
+
+
+    // A new window onto the same plots. Only the window, surface, swapchain and its semaphores are new, everything
+    // else (device, pipelines, tiles, plot buffers) is shared, so this is a lot cheaper than starting another instance.
+    void _addView()
+    {
+        if (_views.size() >= _maxViews) {
+            std::cerr << "Can't open more than " << _maxViews << " views\n";
+            return;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        PlotView& view = _views.emplace_back();
+        std::copy(std::begin(_views[0].viewRange), std::end(_views[0].viewRange), view.viewRange);
+        _createWindow(view);
+        _createSurface(view);
+
+        // The device, queues and render pass were picked for the first window, so the new surface has to fit them
+        QueueFamilyIndices indices = _findQueueFamilies(_physicalDevice);
+        VkBool32 presentSupport = VK_FALSE;
+        vkGetPhysicalDeviceSurfaceSupportKHR(_physicalDevice, indices.presentFamily.value(), view.surface, &presentSupport);
+        std::vector<VkSurfaceFormatKHR> formats = _querySwapChainSupport(_physicalDevice, view.surface).formats;
+        bool formatSupported = std::any_of(formats.begin(), formats.end(), [this](const VkSurfaceFormatKHR& format) {
+            return format.format == _surfaceFormat.format && format.colorSpace == _surfaceFormat.colorSpace;
+        });
+        if (!presentSupport || !formatSupported) {
+            std::cerr << "The new window can't be presented to with the existing device and render pass\n";
+            _destroyView(view);
+            _views.pop_back();
+            return;
+        }
+
+        _createSwapChain(view);
+        _createImageViews(view);
+        _createFrameBuffers(view);
+        _createViewSemaphores(view);
+        std::cout << "Opened view " << _views.size() << " in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << "ms\n";
+    }
+
+
+    // Closing the first window quits, since the data plots and the tile pools were sized for it
+    void _closeView(SDL_WindowID windowId)
+    {
+        PlotView* pView = _findView(windowId);
+        if (pView == nullptr) {
+            return;
+        }
+        if (pView == &_views[0]) {
+            _isRunning = false;
+            return;
+        }
+        vkDeviceWaitIdle(_device);
+        _destroyView(*pView);
+        _views.erase(std::find_if(_views.begin(), _views.end(), [pView](const PlotView& view) { return &view == pView; }));
+        // The views after it moved down, and their glyph instances live at their index
+        for (PlotView& view : _views) {
+            view.builtTicks.reset();
+        }
+    }
+
+
+    void _destroyView(PlotView& view)
+    {
+        vkDestroySemaphore(_device, view.imageAvailableSemaphore, nullptr);
+        vkDestroySemaphore(_device, view.renderFinishedSemaphore, nullptr);
+        for (VkFramebuffer frameBuffer : view.swapchainFrameBuffers) {
+            vkDestroyFramebuffer(_device, frameBuffer, nullptr);
+        }
+        for (VkImageView imageView : view.swapchainImageViews) {
+            vkDestroyImageView(_device, imageView, nullptr);
+        }
+        vkDestroySwapchainKHR(_device, view.swapchain, nullptr);
+        SDL_Vulkan_DestroySurface(_instance, view.surface, nullptr);
+        SDL_DestroyWindow(view.pWindow);
+    }
+
+
+    void _cleanup()
+    {
+        for (PlotView& view : _views) {
+            _destroyView(view);
+        }
+        vkDestroyFence(_device, _inFlightFence, nullptr);
+        for (AsyncQueue& asyncQueue : _asyncQueues) {
+            if (asyncQueue.queue != VK_NULL_HANDLE) {
+                vkDestroySemaphore(_device, asyncQueue.timelineSemaphore, nullptr);
+                vkDestroyCommandPool(_device, asyncQueue.commandPool, nullptr);
+            }
+        }
+        _transientMemory.destroy();
+        vkDestroyQueryPool(_device, _timestampQueryPool, nullptr);
+        vkDestroyDescriptorPool(_device, _descriptorPool, nullptr);
+        vkUnmapMemory(_device, _tileDataBufferMemory);
+        vkUnmapMemory(_device, _functionDataBufferMemory);
+        vkUnmapMemory(_device, _expressionBufferMemory);
+        vkUnmapMemory(_device, _glyphInstanceBufferMemory);
+        VkBuffer plotBuffers[] = {_tileDataBuffer, _functionDataBuffer, _indexBuffer, _expressionBuffer, _glyphInstanceBuffer};
+        VkDeviceMemory plotBufferMemories[] = {_tileDataBufferMemory, _functionDataBufferMemory, _indexBufferMemory, _expressionBufferMemory, _glyphInstanceBufferMemory};
+        for (size_t i = 0; i < std::size(plotBuffers); i++) {
+            vkDestroyBuffer(_device, plotBuffers[i], nullptr);
+            vkFreeMemory(_device, plotBufferMemories[i], nullptr);
+        }
+        for (PlotTilePool& pool : _tilePools) {
+            for (PlotTileChunk& chunk : pool.chunks) {
+                _freeTileChunk(pool, chunk);
+            }
+        }
+        vkDestroyCommandPool(_device, _commandPool, nullptr);
+        for (VkPipeline pipeline : _graphicsPipelines) {
+            vkDestroyPipeline(_device, pipeline, nullptr);
+        }
+        vkDestroyPipelineLayout(_device, _pipelineLayout, nullptr);
+        vkDestroyPipeline(_device, _cullPipeline, nullptr);
+        vkDestroyPipeline(_device, _domainColoringPipeline, nullptr);
+        vkDestroyPipeline(_device, _textPipeline, nullptr);
+        vkDestroyPipelineLayout(_device, _cullPipelineLayout, nullptr);
+        vkDestroySampler(_device, _glyphAtlasSampler, nullptr);
+        vkDestroyImageView(_device, _glyphAtlasImageView, nullptr);
+        vkDestroyImage(_device, _glyphAtlasImage, nullptr);
+        vkFreeMemory(_device, _glyphAtlasImageMemory, nullptr);
+        vkDestroyDescriptorSetLayout(_device, _descriptorSetLayout, nullptr);
+        vkDestroyDescriptorSetLayout(_device, _cullDescriptorSetLayout, nullptr);
+        vkDestroyRenderPass(_device, _renderPass, nullptr);
+        vkDestroyDevice(_device, nullptr);
+        if (_enableValidationLayers) {
+            DestroyDebugUtilsMessengerEXT(_instance, _debugMessenger, nullptr);
+        }
+        vkDestroyInstance(_instance, nullptr);
+        SDL_Quit();
+    }
+
+
+    void _createInstance()
+    {
+        if (_enableValidationLayers && !_checkValidationLayerSupport()) {
+            throw std::runtime_error("Validation layers requested, but none are supported");
+        }
+
+        VkApplicationInfo appInfo{};
+        appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        appInfo.apiVersion = VK_API_VERSION_1_2; // For vkCmdDrawIndexedIndirectCount
+        appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 2);
+        appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 2);
+        appInfo.pApplicationName = "Vulkan lab";
+        appInfo.pEngineName = "No engine";
+
+        VkInstanceCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+        createInfo.pApplicationInfo = &appInfo;
+        createInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+        std::vector<const char*> requiredExtensions = _getRequiredExtensions();
+        createInfo.enabledExtensionCount = requiredExtensions.size();
+        createInfo.ppEnabledExtensionNames = requiredExtensions.data();
+
+        VkDebugUtilsMessengerCreateInfoEXT debugMessengerCreateInfo{};
+        if (_enableValidationLayers) {
+            createInfo.enabledLayerCount = static_cast<uint32_t>(_validationLayers.size());
+            createInfo.ppEnabledLayerNames = _validationLayers.data();
+            _populateDebugMessengerCreateInfo(&debugMessengerCreateInfo);
+            createInfo.pNext = (VkDebugUtilsMessengerCreateInfoEXT*) &debugMessengerCreateInfo;
+        } else {
+            createInfo.enabledLayerCount = 0;
+        }
+
+        VkResult result = vkCreateInstance(&createInfo, nullptr, &_instance);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create vulkan instance");
+        }
+
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+        std::cout << "Available extensions:\n";
+        for (VkExtensionProperties& extension : extensions) {
+            std::cout << "\t" << extension.extensionName << "\n";
+        }
+    }
+
+
+    bool _checkValidationLayerSupport()
+    {
+        uint32_t layerCount = 0;
+        vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+        std::vector<VkLayerProperties> availableLayers(layerCount);
+        vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+
+        for (const char* pLayerName : _validationLayers) {
+            bool layerFound = false;
+            for (const VkLayerProperties& layerProperties : availableLayers) {
+                if (strcmp(pLayerName, layerProperties.layerName) == 0) {
+                    layerFound = true;
+                    break;
+                }
+            }
+
+            if (!layerFound) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    std::vector<const char*> _getRequiredExtensions()
+    {
+        uint32_t SDLExtensionCount = 0;
+        const char* const* ppSDLExtensionNames = SDL_Vulkan_GetInstanceExtensions(&SDLExtensionCount);
+        std::vector<const char*> requiredExtensions(ppSDLExtensionNames, ppSDLExtensionNames + SDLExtensionCount);
+        requiredExtensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
+        if (_enableValidationLayers) {
+            requiredExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        }
+
+        std::cout << "\nRequired Extensions:\n";
+        for (const char* const& extension : requiredExtensions) {
+            std::cout << "\t" << extension << "\n";
+        }
+
+        return requiredExtensions;
+    }
+
+
+    static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
+        VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
+        VkDebugUtilsMessageTypeFlagsEXT messageType,
+        const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
+        void* pUserData
+    ) {
+        std::cerr << "Validation Layer Reports: " << pCallbackData->pMessage << "\n";
+        return VK_FALSE;
+    }
+
+
+    void _populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo)
+    {
+        pCreateInfo->sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+        pCreateInfo->messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+        pCreateInfo->messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT;
+        pCreateInfo->pfnUserCallback = debugCallback;
+        pCreateInfo->pUserData = nullptr;
+    }
+
+
+    void _setupDebugMessenger()
+    {
+        if (!_enableValidationLayers) {
+            return;
+        }
+        VkDebugUtilsMessengerCreateInfoEXT createInfo{};
+        _populateDebugMessengerCreateInfo(&createInfo);
+        createInfo.pUserData = nullptr;
+
+        if (CreateDebugUtilsMessengerEXT(_instance, &createInfo, nullptr, &_debugMessenger) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create DebugUtilsMessenger");
+        }
+    }
+
+
+    void _pickPhysicalDevice()
+    {
+        uint32_t deviceCount = 0;
+        vkEnumeratePhysicalDevices(_instance, &deviceCount, nullptr);
+        if (deviceCount == 0) {
+            throw std::runtime_error("Failed to find GPUs that support Vulkan");
+        }
+        std::vector<VkPhysicalDevice> devices(deviceCount);
+        vkEnumeratePhysicalDevices(_instance, &deviceCount, devices.data());
+
+        for (const VkPhysicalDevice& device : devices) {
+            if (_isDeviceSuitable(device)) {
+                _physicalDevice = device;
+                break;
+            }
+        }
+
+        if (_physicalDevice == VK_NULL_HANDLE) {
+            throw std::runtime_error("You have GPU/s that support Vulkan, though are not suitable for this program.");
+        }
+    }
+
+
+    bool _isDeviceSuitable(VkPhysicalDevice device)
+    {
+        QueueFamilyIndices indices = _findQueueFamilies(device);
+        bool extensionsSupported = _checkDeviceExtensionSupport(device);
+        bool swapchainAdequate = false;
+        if (extensionsSupported) {
+            SwapChainSupportDetails swapchainSupport = _querySwapChainSupport(device, _views[0].surface);
+            swapchainAdequate = !swapchainSupport.formats.empty() && !swapchainSupport.presentModes.empty();
+        }
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+        bool indirectDrawSupported = supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance;
+        // The Vulkan 1.2 feature structs get chained into the feature query and the device creation
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device, &properties);
+        bool vulkan12Supported = properties.apiVersion >= VK_API_VERSION_1_2;
+        return indices.isComplete() && extensionsSupported && swapchainAdequate && indirectDrawSupported && vulkan12Supported;
+    }
+
+
+    QueueFamilyIndices _findQueueFamilies(VkPhysicalDevice device)
+    {
+        QueueFamilyIndices indices;
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+
+        uint32_t i = 0;
+        for (const VkQueueFamilyProperties& queueFamily : queueFamilies) {
+            // The render graph moves passes for a missing async compute or transfer queue to this one, so it needs compute too
+            if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+                indices.graphicsFamily = i;
+            }
+
+            VkBool32 presentSupport = VK_FALSE;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _views[0].surface, &presentSupport);
+            if (presentSupport) {
+                indices.presentFamily = i;
+            }
+
+            if (indices.isComplete()) {
+                break;
+            }
+            i++;
+        }
+
+        for (uint32_t family = 0; family < queueFamilyCount; family++) {
+            if ((queueFamilies[family].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamilies[family].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                indices.asyncComputeFamily = family;
+                break;
+            }
+        }
+        for (uint32_t family = 0; family < queueFamilyCount; family++) {
+            if ((queueFamilies[family].queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamilies[family].queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+                indices.transferFamily = family;
+                break;
+            }
+        }
+        return indices;
+    }
+
+
+    void _createLogicalDevice()
+    {
+        QueueFamilyIndices indices = _findQueueFamilies(_physicalDevice);
+        std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+        if (indices.asyncComputeFamily.has_value()) {
+            uniqueQueueFamilies.insert(indices.asyncComputeFamily.value());
+        }
+        if (indices.transferFamily.has_value()) {
+            uniqueQueueFamilies.insert(indices.transferFamily.value());
+        }
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) {
             VkDeviceQueueCreateInfo queueCreateInfo{};
@@ -348,488 +3057,2354 @@ private:
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
-        VkPhysicalDeviceFeatures physicalDeviceFeatures{}; // Initialise everything as VK_FALSE
+        // drawIndirectCount is optional, without it the culled draws are just left with an indexCount of 0
+        VkPhysicalDeviceVulkan12Features supportedVulkan12Features{};
+        supportedVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures{};
+        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures.pNext = &supportedVulkan12Features;
+        vkGetPhysicalDeviceFeatures2(_physicalDevice, &supportedFeatures);
+        _drawIndirectCountSupported = supportedVulkan12Features.drawIndirectCount == VK_TRUE;
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features{}; // Initialise everything as VK_FALSE
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.drawIndirectCount = supportedVulkan12Features.drawIndirectCount;
+        vulkan12Features.timelineSemaphore = VK_TRUE; // Required by Vulkan 1.2
+        VkPhysicalDeviceFeatures2 physicalDeviceFeatures{};
+        physicalDeviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        physicalDeviceFeatures.pNext = &vulkan12Features;
+        physicalDeviceFeatures.features.multiDrawIndirect = VK_TRUE;
+        physicalDeviceFeatures.features.drawIndirectFirstInstance = VK_TRUE;
+
+        VkDeviceCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &physicalDeviceFeatures;
+        createInfo.pQueueCreateInfos = queueCreateInfos.data();
+        createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
+        createInfo.pEnabledFeatures = nullptr; // Given through physicalDeviceFeatures in pNext instead
+
+        // The memory budget extension is optional, without it the tile residency limit just stays at the maximum
+        std::vector<const char*> extensions = _deviceExtensions;
+        _memoryBudgetSupported = _isDeviceExtensionSupported(_physicalDevice, "VK_EXT_memory_budget");
+        if (_memoryBudgetSupported) {
+            extensions.push_back("VK_EXT_memory_budget");
+        }
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
+
+        if (_enableValidationLayers) {
+            createInfo.enabledLayerCount = static_cast<uint32_t>(_validationLayers.size());
+            createInfo.ppEnabledLayerNames = _validationLayers.data();
+        } else {
+            createInfo.enabledLayerCount = 0;
+        }
+        VkResult deviceCreateResult = vkCreateDevice(_physicalDevice, &createInfo, nullptr, &_device);
+        if (deviceCreateResult != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create logical device.\n");
+        }
+
+        vkGetDeviceQueue(_device, indices.graphicsFamily.value(), 0, &_graphicsQueue);
+        vkGetDeviceQueue(_device, indices.presentFamily.value(), 0, &_presentQueue);
+        _graphicsQueueFamily = indices.graphicsFamily.value();
+        std::optional<uint32_t> asyncFamilies[] = {indices.transferFamily, indices.asyncComputeFamily}; // In RenderGraphQueue order
+        for (size_t i = 0; i < std::size(_asyncQueues); i++) {
+            if (asyncFamilies[i].has_value()) {
+                _asyncQueues[i].family = asyncFamilies[i].value();
+                vkGetDeviceQueue(_device, _asyncQueues[i].family, 0, &_asyncQueues[i].queue);
+                std::cout << "Using the " << getRenderGraphQueueName(static_cast<RenderGraphQueue>(i)) << " queue family " << _asyncQueues[i].family << "\n";
+            }
+        }
+        _transientMemory.initialise(_device, _physicalDevice, _getQueueFamilies());
+
+        std::cout << "successfullly created logical device!\n";
+    }
+
+
+    void _createSurface(PlotView& view)
+    {
+        if (!SDL_Vulkan_CreateSurface(view.pWindow, _instance, nullptr, &view.surface)) {
+            throw std::runtime_error("Failed to create window surface.\n");
+        }
+    }
+
+
+    bool _isDeviceExtensionSupported(VkPhysicalDevice device, const char* pExtensionName)
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+        return std::any_of(availableExtensions.begin(), availableExtensions.end(), [pExtensionName](const VkExtensionProperties& extension) {
+            return std::strcmp(extension.extensionName, pExtensionName) == 0;
+        });
+    }
+
+
+    bool _checkDeviceExtensionSupport(VkPhysicalDevice device)
+    {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+        std::set<std::string> requiredExtensions(_deviceExtensions.begin(), _deviceExtensions.end());
+        std::cout << "\nAvailable device extensions:\n";
+        for (const VkExtensionProperties& extension : availableExtensions) {
+            std::cout << "\t" << extension.extensionName << "\n";
+            requiredExtensions.erase(extension.extensionName);
+        }
+        return requiredExtensions.empty();
+    }
+
+
+    SwapChainSupportDetails _querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
+    {
+        SwapChainSupportDetails details;
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
+
+        uint32_t formatCount = 0;
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
+        if (formatCount != 0) {
+            details.formats.resize(formatCount);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
+        }
+
+        uint32_t presentModeCount = 0;
+        vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
+        if (presentModeCount != 0) {
+            details.presentModes.resize(presentModeCount);
+            vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
+        }
+
+        return details;
+    }
+
+
+    VkSurfaceFormatKHR _chooseSwapSurfaceFormat(std::vector<VkSurfaceFormatKHR>& availableFormats)
+    {
+        for (const auto& availableFormat : availableFormats) {
+            if (availableFormat.format == VK_FORMAT_R8G8B8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+                return availableFormat;
+            }
+        }
+        return availableFormats[0];
+    }
+
+
+    // Split out of the swapchain creation so the render pass and pipelines don't have to wait for the swapchain
+    void _chooseSurfaceFormat()
+    {
+        SwapChainSupportDetails swapchainSupport = _querySwapChainSupport(_physicalDevice, _views[0].surface);
+        _surfaceFormat = _chooseSwapSurfaceFormat(swapchainSupport.formats);
+    }
+
+
+    VkPresentModeKHR _chooseSwapPresentMode(std::vector<VkPresentModeKHR>& availablePresentModes)
+    {
+        for (const auto& presentMode : availablePresentModes) {
+            if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+                return presentMode;
+            }
+        }
+        return VK_PRESENT_MODE_FIFO_KHR;
+    }
+
+
+    // Runs on a worker thread during startup, so the window's pixel size comes from the window step rather than SDL
+    VkExtent2D _chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, VkExtent2D windowPixelSize)
+    {
+        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
+            return capabilities.currentExtent;
+        } else {
+            VkExtent2D actualExtent = windowPixelSize;
+            actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+            actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+            return actualExtent;
+        }
+    }
+
+
+    void _createSwapChain(PlotView& view)
+    {
+        SwapChainSupportDetails swapchainSupport = _querySwapChainSupport(_physicalDevice, view.surface);
+        VkSurfaceFormatKHR surfaceFormat = _surfaceFormat;
+        VkPresentModeKHR presentMode = _chooseSwapPresentMode(swapchainSupport.presentModes);
+        VkExtent2D extent = _chooseSwapExtent(swapchainSupport.capabilities, view.windowPixelSize);
+
+        uint32_t imageCount = swapchainSupport.capabilities.minImageCount + 1;
+        // a maxImageCount of 0 means there is no maximum. So this is 'if (there is a maximum) and (imageCount is greater than it)'
+        if (swapchainSupport.capabilities.maxImageCount > 0 && imageCount > swapchainSupport.capabilities.maxImageCount) {
+            imageCount = swapchainSupport.capabilities.maxImageCount;
+        }
+        
+        VkSwapchainCreateInfoKHR createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        createInfo.surface = view.surface;
+        createInfo.minImageCount = imageCount;
+        createInfo.imageFormat = surfaceFormat.format;
+        createInfo.imageColorSpace = surfaceFormat.colorSpace;
+        createInfo.imageExtent = extent;
+        createInfo.imageArrayLayers = 1;
+        createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+        QueueFamilyIndices indices = _findQueueFamilies(_physicalDevice);
+        uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+        if (indices.graphicsFamily != indices.presentFamily) {
+            createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = 2;
+            createInfo.pQueueFamilyIndices = queueFamilyIndices;
+        } else {
+            createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            createInfo.queueFamilyIndexCount = 0; // optional.
+            createInfo.pQueueFamilyIndices = nullptr; // optional.
+        }
+        createInfo.preTransform = swapchainSupport.capabilities.currentTransform;
+        createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        createInfo.presentMode = presentMode;
+        createInfo.clipped = VK_TRUE;
+        createInfo.oldSwapchain = VK_NULL_HANDLE;
+        
+        VkResult result = vkCreateSwapchainKHR(_device, &createInfo, nullptr, &view.swapchain);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create swapchain.\n");
+        }
+
+        vkGetSwapchainImagesKHR(_device, view.swapchain, &imageCount, nullptr);
+        view.swapchainImages.resize(imageCount);
+        vkGetSwapchainImagesKHR(_device, view.swapchain, &imageCount, view.swapchainImages.data());
+        view.swapchainExtent = extent;
+
+        std::cout << "successfully created swapchain!\n";
+    }
+
+
+    void _createImageViews(PlotView& view)
+    {
+        view.swapchainImageViews.resize(view.swapchainImages.size());
+        for (uint32_t i = 0; i < view.swapchainImages.size(); i++) {
+            VkImageViewCreateInfo createInfo{};
+            createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            createInfo.image = view.swapchainImages[i];
+            createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            createInfo.format = _surfaceFormat.format;
+            createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+            createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+            createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+            createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+            createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            createInfo.subresourceRange.baseMipLevel = 0;
+            createInfo.subresourceRange.levelCount = 1;
+            createInfo.subresourceRange.baseArrayLayer = 0;
+            createInfo.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(_device, &createInfo, nullptr, &view.swapchainImageViews[i]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create image views!\n");
+            }
+        }
+    }
+
+
+    // The plot and domain coloring pipelines share this layout, both only need the view range
+    void _createPipelineLayout()
+    {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(PlotPushConstants);
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &_descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline layout.\n");
+        }
+    }
+
+
+    void _createGraphicsPipeline()
+    {
+        VkShaderModule vertShaderModule = _shaderModules.at("shaders/vert.spv");
+        VkShaderModule fragShaderModule = _shaderModules.at("shaders/frag.spv");
+
+        VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+        vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+        vertShaderStageInfo.module = vertShaderModule;
+        vertShaderStageInfo.pName = "main";
+
+        VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+        fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        fragShaderStageInfo.module = fragShaderModule;
+        fragShaderStageInfo.pName = "main";
+
+        VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
+        
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+        inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+        std::vector<VkDynamicState> dynamicStates = {
+            VK_DYNAMIC_STATE_VIEWPORT,
+            VK_DYNAMIC_STATE_SCISSOR
+        };
+
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+        dynamicState.pDynamicStates = dynamicStates.data();
+
+        VkPipelineViewportStateCreateInfo viewportState{};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.depthClampEnable = VK_FALSE;
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+        rasterizer.depthBiasEnable = VK_FALSE;
+        rasterizer.depthBiasConstantFactor = 0.0f;
+        rasterizer.depthBiasClamp = 0.0f;
+        rasterizer.depthBiasSlopeFactor = 0.0f;
+
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.sampleShadingEnable = VK_FALSE;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        multisampling.minSampleShading = 1.0f;
+        multisampling.pSampleMask = nullptr;
+        multisampling.alphaToCoverageEnable = VK_FALSE;
+        multisampling.alphaToOneEnable = VK_FALSE;
+
+        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachment.blendEnable = VK_FALSE;
+        colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+        colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+        colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+        colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+        VkPipelineColorBlendStateCreateInfo colorBlending{};
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.logicOpEnable = VK_FALSE;
+        colorBlending.logicOp = VK_LOGIC_OP_COPY;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &colorBlendAttachment;
+        colorBlending.blendConstants[0] = 0.0f;
+        colorBlending.blendConstants[1] = 0.0f;
+        colorBlending.blendConstants[2] = 0.0f;
+        colorBlending.blendConstants[3] = 0.0f;
+
+        // One pipeline per vertex format, they only differ in the vertex input state. The shader is the same
+        // since the unorm formats arrive in [0, 1] and the tile's dequantisation values take care of the rest.
+        for (uint32_t format = 0; format < static_cast<uint32_t>(PlotVertexFormat::Count); format++) {
+            VkVertexInputBindingDescription bindingDescription{};
+            VkVertexInputAttributeDescription attributeDescriptions[2]{};
+            _getVertexInputDescriptions(static_cast<PlotVertexFormat>(format), &bindingDescription, attributeDescriptions);
+
+            VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+            vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            vertexInputInfo.vertexBindingDescriptionCount = 1;
+            vertexInputInfo.vertexAttributeDescriptionCount = 2;
+            vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions;
+            vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+
+            VkGraphicsPipelineCreateInfo pipelineInfo{};
+            pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            pipelineInfo.stageCount = 2;
+            pipelineInfo.pStages = shaderStages;
+            pipelineInfo.pVertexInputState = &vertexInputInfo;
+            pipelineInfo.pInputAssemblyState = &inputAssembly;
+            pipelineInfo.pViewportState = &viewportState;
+            pipelineInfo.pRasterizationState = &rasterizer;
+            pipelineInfo.pMultisampleState = &multisampling;
+            pipelineInfo.pDepthStencilState = nullptr;
+            pipelineInfo.pColorBlendState = &colorBlending;
+            pipelineInfo.pDynamicState = &dynamicState;
+            pipelineInfo.layout = _pipelineLayout;
+            pipelineInfo.renderPass = _renderPass;
+            pipelineInfo.subpass = 0;
+            pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+            pipelineInfo.basePipelineIndex = -1;
+
+            if (vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_graphicsPipelines[format]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create graphics pipeline\n");
+            }
+        }
+
+        std::cout << "Successfully created graphics pipeline!\n";
+    }
+
+
+    // Shared by every pipeline:
+    // 0 = tile data, 1 = function data, 4 = domain coloring expression, 5 = glyph instances, 6 = glyph atlas
+    // Bindings 2 and 3 used to be the draw buffers, which are per view and per frame now, in the cull pass's set 1:
+    // 0 = indirect draw commands, 1 = draw counts
+    void _createDescriptorSetLayout()
+    {
+        VkDescriptorSetLayoutBinding bindings[5]{};
+        const uint32_t bindingNumbers[5] = {0, 1, 4, 5, 6};
+        for (uint32_t i = 0; i < 5; i++) {
+            bindings[i].binding = bindingNumbers[i];
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+        }
+        bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+        bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+        bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[3].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+        bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[4].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+        VkDescriptorSetLayoutCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        createInfo.bindingCount = 5;
+        createInfo.pBindings = bindings;
+        if (vkCreateDescriptorSetLayout(_device, &createInfo, nullptr, &_descriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create descriptor set layout");
+        }
+
+        VkDescriptorSetLayoutBinding cullBindings[2]{};
+        for (uint32_t i = 0; i < 2; i++) {
+            cullBindings[i].binding = i;
+            cullBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            cullBindings[i].descriptorCount = 1;
+            cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        }
+        createInfo.bindingCount = 2;
+        createInfo.pBindings = cullBindings;
+        if (vkCreateDescriptorSetLayout(_device, &createInfo, nullptr, &_cullDescriptorSetLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create cull descriptor set layout");
+        }
+    }
+
+
+    // Same layout and render pass as the plots, but no vertex input and a full screen triangle made up in the vertex shader
+    void _createDomainColoringPipeline()
+    {
+        VkShaderModule vertShaderModule = _shaderModules.at("shaders/fullscreen.spv");
+        VkShaderModule fragShaderModule = _shaderModules.at("shaders/domainColoring.spv");
+
+        VkPipelineShaderStageCreateInfo shaderStages[2]{};
+        shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        shaderStages[0].module = vertShaderModule;
+        shaderStages[0].pName = "main";
+        shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        shaderStages[1].module = fragShaderModule;
+        shaderStages[1].pName = "main";
+
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+        VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = 2;
+        dynamicState.pDynamicStates = dynamicStates;
+
+        VkPipelineViewportStateCreateInfo viewportState{};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.cullMode = VK_CULL_MODE_NONE;
+        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        multisampling.minSampleShading = 1.0f;
+
+        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachment.blendEnable = VK_FALSE;
+
+        VkPipelineColorBlendStateCreateInfo colorBlending{};
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &colorBlendAttachment;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = shaderStages;
+        pipelineInfo.pVertexInputState = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.layout = _pipelineLayout;
+        pipelineInfo.renderPass = _renderPass;
+        pipelineInfo.subpass = 0;
+        pipelineInfo.basePipelineIndex = -1;
+        if (vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_domainColoringPipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create domain coloring pipeline\n");
+        }
+
+        std::cout << "Successfully created domain coloring pipeline!\n";
+    }
+
+
+    // Every label quad of a view in one instanced draw, six vertices per instance made up in the vertex shader.
+    // Alpha blended over the plots, the SDF gives the glyphs soft edges and an outline.
+    void _createTextPipeline()
+    {
+        VkPipelineShaderStageCreateInfo shaderStages[2]{};
+        shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+        shaderStages[0].module = _shaderModules.at("shaders/textVert.spv");
+        shaderStages[0].pName = "main";
+        shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        shaderStages[1].module = _shaderModules.at("shaders/textFrag.spv");
+        shaderStages[1].pName = "main";
+
+        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+        VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+        VkPipelineDynamicStateCreateInfo dynamicState{};
+        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+        dynamicState.dynamicStateCount = 2;
+        dynamicState.pDynamicStates = dynamicStates;
+
+        VkPipelineViewportStateCreateInfo viewportState{};
+        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+        viewportState.viewportCount = 1;
+        viewportState.scissorCount = 1;
+
+        VkPipelineRasterizationStateCreateInfo rasterizer{};
+        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+        rasterizer.lineWidth = 1.0f;
+        rasterizer.cullMode = VK_CULL_MODE_NONE;
+        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+        VkPipelineMultisampleStateCreateInfo multisampling{};
+        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        multisampling.minSampleShading = 1.0f;
+
+        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+        colorBlendAttachment.blendEnable = VK_TRUE;
+        colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+        colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+        colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+        colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+        VkPipelineColorBlendStateCreateInfo colorBlending{};
+        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+        colorBlending.attachmentCount = 1;
+        colorBlending.pAttachments = &colorBlendAttachment;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        pipelineInfo.stageCount = 2;
+        pipelineInfo.pStages = shaderStages;
+        pipelineInfo.pVertexInputState = &vertexInputInfo;
+        pipelineInfo.pInputAssemblyState = &inputAssembly;
+        pipelineInfo.pViewportState = &viewportState;
+        pipelineInfo.pRasterizationState = &rasterizer;
+        pipelineInfo.pMultisampleState = &multisampling;
+        pipelineInfo.pColorBlendState = &colorBlending;
+        pipelineInfo.pDynamicState = &dynamicState;
+        pipelineInfo.layout = _pipelineLayout;
+        pipelineInfo.renderPass = _renderPass;
+        pipelineInfo.subpass = 0;
+        pipelineInfo.basePipelineIndex = -1;
+        if (vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_textPipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create text pipeline\n");
+        }
+
+        std::cout << "Successfully created text pipeline!\n";
+    }
+
+
+    void _createCullPipeline()
+    {
+        VkShaderModule cullShaderModule = _shaderModules.at("shaders/cull.spv");
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(CullPushConstants);
+
+        VkDescriptorSetLayout setLayouts[] = {_descriptorSetLayout, _cullDescriptorSetLayout};
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 2;
+        pipelineLayoutInfo.pSetLayouts = setLayouts;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_cullPipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create cull pipeline layout.\n");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = cullShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = _cullPipelineLayout;
+        if (vkCreateComputePipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_cullPipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create cull pipeline\n");
+        }
+
+        std::cout << "Successfully created cull pipeline!\n";
+    }
+
+
+    void _getVertexInputDescriptions(PlotVertexFormat format, VkVertexInputBindingDescription* pBinding, VkVertexInputAttributeDescription* pAttributes)
+    {
+        pBinding->binding = 0;
+        pBinding->inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        pAttributes[0].binding = 0;
+        pAttributes[0].location = 0;
+        pAttributes[1].binding = 0;
+        pAttributes[1].location = 1;
+
+        if (format == PlotVertexFormat::Packed16) {
+            pBinding->stride = sizeof(PackedFunctionVertex);
+            pAttributes[0].format = VK_FORMAT_R16_UNORM;
+            pAttributes[0].offset = offsetof(PackedFunctionVertex, x);
+            pAttributes[1].format = VK_FORMAT_R16G16B16A16_UNORM;
+            pAttributes[1].offset = offsetof(PackedFunctionVertex, basis);
+        } else {
+            pBinding->stride = sizeof(FunctionVertex);
+            pAttributes[0].format = VK_FORMAT_R32_SFLOAT;
+            pAttributes[0].offset = offsetof(FunctionVertex, x);
+            pAttributes[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+            pAttributes[1].offset = offsetof(FunctionVertex, basis);
+        }
+    }
+
+
+    // Only needs the file system, so it runs right at the start of startup
+    void _loadShaderCode()
+    {
+        for (const std::string& fileName : _shaderFileNames) {
+            _shaderCode[fileName] = _readFile(fileName);
+        }
+    }
+
+
+    // Every module is created up front so the pipelines can compile in parallel, and destroyed once they all have
+    void _createShaderModules()
+    {
+        for (const std::string& fileName : _shaderFileNames) {
+            _shaderModules[fileName] = _createShaderModule(_shaderCode.at(fileName));
+        }
+        _shaderCode.clear();
+    }
+
+
+    void _destroyShaderModules()
+    {
+        for (const auto& [fileName, shaderModule] : _shaderModules) {
+            vkDestroyShaderModule(_device, shaderModule, nullptr);
+        }
+        _shaderModules.clear();
+    }
+
+
+    static std::vector<char> _readFile(const std::string& fileName)
+    {
+        std::ifstream file(fileName, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file " + fileName);
+        }
+
+        size_t fileSize = (size_t)file.tellg();
+        std::vector<char> buffer(fileSize);
+        file.seekg(0);
+        file.read(buffer.data(), fileSize);
+        file.close();
+        return buffer;
+    }
+
+
+    VkShaderModule _createShaderModule(const std::vector<char>& code)
+    {
+        VkShaderModuleCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = code.size();
+        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        VkShaderModule shaderModule;
+        VkResult shaderModuleCreateResult= vkCreateShaderModule(_device, &createInfo, nullptr, &shaderModule);
+        if (shaderModuleCreateResult != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create shader module.");
+        }
+        return shaderModule;
+    }
+
+
+    void _createRenderPass()
+    {
+        VkAttachmentDescription colorAttachment{};
+        colorAttachment.format = _surfaceFormat.format;
+        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        // The render graph moves the image in and out of this layout with its own barriers
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference colorAttachmentRef{};
+        colorAttachmentRef.attachment = 0;
+        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorAttachmentRef;
+
+        VkRenderPassCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        createInfo.attachmentCount = 1;
+        createInfo.pAttachments = &colorAttachment;
+        createInfo.subpassCount = 1;
+        createInfo.pSubpasses = &subpass;
+
+        if (vkCreateRenderPass(_device, &createInfo, nullptr, &_renderPass) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render pass");
+        }
+        std::cout << "successfully created Render pass!\n";
+    }
+
+
+    void _createFrameBuffers(PlotView& view)
+    {
+        view.swapchainFrameBuffers.resize(view.swapchainImageViews.size());
+        for (size_t i = 0; i < view.swapchainFrameBuffers.size(); i++) {
+            VkImageView attachments[] = {
+                view.swapchainImageViews[i]
+            };
+            VkFramebufferCreateInfo createInfo{};
+            createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            createInfo.renderPass = _renderPass;
+            createInfo.attachmentCount = 1;
+            createInfo.pAttachments = attachments;
+            createInfo.width = view.swapchainExtent.width;
+            createInfo.height = view.swapchainExtent.height;
+            createInfo.layers = 1;
+            if (vkCreateFramebuffer(_device, &createInfo, nullptr, &view.swapchainFrameBuffers[i]) != VK_SUCCESS) {
+               throw std::runtime_error("Failed to create framebuffer");
+            }
+        }
+        std::cout << "Successfully created frame buffers!\n";
+    }
+
+
+    void _createCommandPool()
+    {
+        QueueFamilyIndices indices = _findQueueFamilies(_physicalDevice);
+        VkCommandPoolCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        createInfo.queueFamilyIndex = indices.graphicsFamily.value();
+        if (vkCreateCommandPool(_device, &createInfo, nullptr, &_commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create command pool\n");
+        }
+        for (AsyncQueue& asyncQueue : _asyncQueues) {
+            if (asyncQueue.queue == VK_NULL_HANDLE) {
+                continue;
+            }
+            createInfo.queueFamilyIndex = asyncQueue.family;
+            if (vkCreateCommandPool(_device, &createInfo, nullptr, &asyncQueue.commandPool) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create command pool\n");
+            }
+        }
+    }
+
+
+    void _createCommandBuffer()
+    {
+        VkCommandBufferAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.commandPool = _commandPool;
+        allocateInfo.commandBufferCount = 1;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        if (vkAllocateCommandBuffers(_device, &allocateInfo, &_commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffers.");
+        }
+        for (AsyncQueue& asyncQueue : _asyncQueues) {
+            if (asyncQueue.queue == VK_NULL_HANDLE) {
+                continue;
+            }
+            allocateInfo.commandPool = asyncQueue.commandPool;
+            if (vkAllocateCommandBuffers(_device, &allocateInfo, &asyncQueue.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate command buffers.");
+            }
+        }
+    }
+
+
+    // Async queues that don't exist hand their passes to the graphics queue
+    RenderGraphQueue _getPassQueue(RenderGraphQueue queue)
+    {
+        if (queue != RenderGraphQueue::Graphics && _asyncQueues[static_cast<size_t>(queue)].queue == VK_NULL_HANDLE) {
+            return RenderGraphQueue::Graphics;
+        }
+        return queue;
+    }
+
+
+    // The frame as a render graph: tile uploads on the transfer queue, then for each view clearing its draw counts
+    // and culling on the compute queue, and its plot render pass. None of the passes below write barriers themselves,
+    // the graph works them out from the declared uses, along with the waits between the queues.
+    // Each view's draw buffers are transient. With everything on the graphics queue the views take turns, so they
+    // all share the one set of draw buffers in memory.
+    void _recordFrame(RenderGraph& graph)
+    {
+        // The acquire semaphores are waited on at the color attachment stage, so the first transitions have to wait for them too
+        std::vector<RenderGraph::Resource> swapchainImages;
+        for (const PlotView& view : _views) {
+            swapchainImages.push_back(graph.importImage(view.swapchainImages[view.imageIndex], VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, RenderGraphUsage::Present));
+        }
+        std::vector<RenderGraph::Resource> vertexBuffers;
+        std::vector<std::pair<RenderGraph::Resource, RenderGraphUsage>> uploadUses;
+        for (const PlotTilePool& pool : _tilePools) {
+            for (const PlotTileChunk& chunk : pool.chunks) {
+                if (chunk.vertexBuffer == VK_NULL_HANDLE) {
+                    continue;
+                }
+                vertexBuffers.push_back(graph.importBuffer(chunk.vertexBuffer));
+                if (!chunk.pendingCopies.empty()) {
+                    uploadUses.push_back({vertexBuffers.back(), RenderGraphUsage::TransferWrite});
+                }
+            }
+        }
+        RenderGraph::Resource indexBuffer = graph.importBuffer(_indexBuffer);
+        RenderGraph::Resource tileData = graph.importBuffer(_tileDataBuffer);
+        RenderGraph::Resource functionData = graph.importBuffer(_functionDataBuffer);
+
+        if (!uploadUses.empty()) {
+            graph.addPass("tile uploads", uploadUses, [this](VkCommandBuffer commandBuffer) {
+                for (PlotTilePool& pool : _tilePools) {
+                    for (PlotTileChunk& chunk : pool.chunks) {
+                        if (chunk.pendingCopies.empty()) {
+                            continue;
+                        }
+                        vkCmdCopyBuffer(commandBuffer, chunk.stagingBuffer, chunk.vertexBuffer, static_cast<uint32_t>(chunk.pendingCopies.size()), chunk.pendingCopies.data());
+                        chunk.pendingCopies.clear();
+                    }
+                }
+            }, _getPassQueue(RenderGraphQueue::Transfer));
+        }
+
+        const uint32_t drawListCount = _getTileChunkCount() * static_cast<uint32_t>(PlotVertexFormat::Count);
+        const VkBufferUsageFlags drawBufferUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        std::vector<std::pair<RenderGraph::Resource, RenderGraph::Resource>> drawBuffers;
+        for (uint32_t viewIndex = 0; viewIndex < _views.size(); viewIndex++) {
+            RenderGraph::Resource drawCommands = graph.createBuffer(sizeof(VkDrawIndexedIndirectCommand) * _tilesPerChunk * drawListCount, drawBufferUsage);
+            RenderGraph::Resource drawCounts = graph.createBuffer(sizeof(uint32_t) * drawListCount, drawBufferUsage);
+            drawBuffers.push_back({drawCommands, drawCounts});
+
+            std::vector<std::pair<RenderGraph::Resource, RenderGraphUsage>> clearUses = {{drawCounts, RenderGraphUsage::TransferWrite}};
+            if (!_drawIndirectCountSupported) {
+                clearUses.push_back({drawCommands, RenderGraphUsage::TransferWrite});
+            }
+            graph.addPass("clear draw counts", clearUses, [this, &graph, drawCommands, drawCounts](VkCommandBuffer commandBuffer) {
+                vkCmdFillBuffer(commandBuffer, graph.getBuffer(drawCounts), 0, VK_WHOLE_SIZE, 0);
+                if (!_drawIndirectCountSupported) {
+                    // Without the count the whole buffer gets drawn, so the unused commands need an indexCount of 0
+                    vkCmdFillBuffer(commandBuffer, graph.getBuffer(drawCommands), 0, VK_WHOLE_SIZE, 0);
+                }
+            }, _getPassQueue(RenderGraphQueue::Compute));
+
+            std::vector<std::pair<RenderGraph::Resource, RenderGraphUsage>> cullUses = {
+                {drawCommands, RenderGraphUsage::ComputeWrite},
+                {drawCounts, RenderGraphUsage::ComputeReadWrite},
+                {tileData, RenderGraphUsage::ComputeRead},
+                {functionData, RenderGraphUsage::ComputeRead}
+            };
+            graph.addPass("cull", cullUses, [this, viewIndex](VkCommandBuffer commandBuffer) {
+                _recordPlotCulling(commandBuffer, viewIndex);
+            }, _getPassQueue(RenderGraphQueue::Compute));
+
+            std::vector<std::pair<RenderGraph::Resource, RenderGraphUsage>> plotUses = {
+                {indexBuffer, RenderGraphUsage::IndexRead},
+                {drawCommands, RenderGraphUsage::IndirectRead},
+                {drawCounts, RenderGraphUsage::IndirectRead},
+                {tileData, RenderGraphUsage::VertexShaderRead},
+                {functionData, RenderGraphUsage::VertexShaderRead},
+                {swapchainImages[viewIndex], RenderGraphUsage::ColorAttachmentWrite}
+            };
+            for (RenderGraph::Resource vertexBuffer : vertexBuffers) {
+                plotUses.push_back({vertexBuffer, RenderGraphUsage::VertexAttributeRead});
+            }
+            graph.addPass("plot", plotUses, [this, &graph, viewIndex, drawCommands, drawCounts](VkCommandBuffer commandBuffer) {
+                _recordPlotRenderPass(commandBuffer, viewIndex, graph.getBuffer(drawCommands), graph.getBuffer(drawCounts));
+            });
+        }
+
+        graph.compile(_transientMemory);
+        _writeCullDescriptorSets(graph, drawBuffers);
+        _frameStats.barriers += graph.getBarrierCount();
+        _frameStats.transientBufferBytes = graph.getTransientBufferSize();
+        _frameStats.transientMemoryBytes = _transientMemory.getSize();
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = 0;
+        beginInfo.pInheritanceInfo = nullptr;
+        for (size_t i = 0; i < std::size(_asyncQueues); i++) {
+            if (!graph.hasPasses(static_cast<RenderGraphQueue>(i))) {
+                continue;
+            }
+            vkResetCommandBuffer(_asyncQueues[i].commandBuffer, 0);
+            if (vkBeginCommandBuffer(_asyncQueues[i].commandBuffer, &beginInfo) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to begin command buffer recording\n");
+            }
+            graph.record(static_cast<RenderGraphQueue>(i), _asyncQueues[i].commandBuffer);
+            if (vkEndCommandBuffer(_asyncQueues[i].commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to execute command buffer.\n");
+            }
+        }
+
+        vkResetCommandBuffer(_commandBuffer, 0);
+        if (vkBeginCommandBuffer(_commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin command buffer recording\n");
+        }
+        if (_timestampsSupported) {
+            vkCmdResetQueryPool(_commandBuffer, _timestampQueryPool, 0, 2);
+        }
+        graph.record(RenderGraphQueue::Graphics, _commandBuffer);
+        if (vkEndCommandBuffer(_commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to execute command buffer.\n");
+        }
+        _timestampsWritten = _timestampsSupported;
+    }
+
+
+    // The timestamps cover every view, from the start of the first one to the end of the last
+    void _recordPlotRenderPass(VkCommandBuffer commandBuffer, uint32_t viewIndex, VkBuffer drawCommandBuffer, VkBuffer drawCountBuffer)
+    {
+        const PlotView& view = _views[viewIndex];
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = _renderPass;
+        renderPassInfo.framebuffer = view.swapchainFrameBuffers[view.imageIndex];
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = view.swapchainExtent;
+        VkClearValue clearColor = {{{1.0f, 0.0f, 0.0f, 1.0f}}}; // Red ClearColor;
+        renderPassInfo.clearValueCount = 1;
+        renderPassInfo.pClearValues = &clearColor;
+        
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(view.swapchainExtent.width);
+        viewport.height = static_cast<float>(view.swapchainExtent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        
+        VkRect2D scissor{};
+        scissor.offset = {0, 0};
+        scissor.extent = view.swapchainExtent;
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        // Every visible tile of every plot in one indirect draw per vertex format, the CPU cost doesn't depend on the plot count
+        if (viewIndex == 0 && _timestampsSupported) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _timestampQueryPool, 0);
+        }
+        PlotPushConstants pushConstants{};
+        std::copy(std::begin(view.viewRange), std::end(view.viewRange), pushConstants.viewRange);
+        pushConstants.viewportSize[0] = static_cast<float>(view.swapchainExtent.width);
+        pushConstants.viewportSize[1] = static_cast<float>(view.swapchainExtent.height);
+        vkCmdPushConstants(commandBuffer, _pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PlotPushConstants), &pushConstants);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 0, 1, &_descriptorSet, 0, nullptr);
+        if (_domainColoringEnabled) {
+            // A single full screen triangle, every pixel evaluates the expression itself so there's no geometry at all
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _domainColoringPipeline);
+            vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+        }
+        vkCmdBindIndexBuffer(commandBuffer, _indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+        // One draw list per chunk, since each chunk has its own vertex buffer. Chunks that aren't allocated hold no tiles.
+        const uint32_t chunksPerFormat = _getTileChunkCount();
+        for (uint32_t format = 0; format < static_cast<uint32_t>(PlotVertexFormat::Count); format++) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _graphicsPipelines[format]);
+            for (uint32_t chunk = 0; chunk < chunksPerFormat; chunk++) {
+                if (_tilePools[format].chunks[chunk].vertexBuffer == VK_NULL_HANDLE) {
+                    continue;
+                }
+                VkDeviceSize vertexBufferOffset = 0;
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &_tilePools[format].chunks[chunk].vertexBuffer, &vertexBufferOffset);
+
+                uint32_t drawList = format * chunksPerFormat + chunk;
+                VkDeviceSize commandOffset = sizeof(VkDrawIndexedIndirectCommand) * _tilesPerChunk * drawList;
+                if (_drawIndirectCountSupported) {
+                    vkCmdDrawIndexedIndirectCount(commandBuffer, drawCommandBuffer, commandOffset, drawCountBuffer, sizeof(uint32_t) * drawList, _tilesPerChunk, sizeof(VkDrawIndexedIndirectCommand));
+                } else {
+                    vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer, commandOffset, _tilesPerChunk, sizeof(VkDrawIndexedIndirectCommand));
+                }
+            }
+        }
+        // All of the view's tick marks and labels, firstInstance picks its part of the glyph instance buffer
+        if (view.glyphInstanceCount > 0) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _textPipeline);
+            vkCmdDraw(commandBuffer, 6, view.glyphInstanceCount, 0, viewIndex * _maxGlyphInstances);
+        }
+        if (viewIndex + 1 == _views.size() && _timestampsSupported) {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _timestampQueryPool, 1);
+        }
+
+        vkCmdEndRenderPass(commandBuffer);
+    }
+
+
+    // Runs the cull shader over every tile slot, which writes the draw commands for the ones visible in the view
+    // into the view's own draw buffers, set 1
+    void _recordPlotCulling(VkCommandBuffer commandBuffer, uint32_t viewIndex)
+    {
+        const PlotView& view = _views[viewIndex];
+        CullPushConstants pushConstants{};
+        std::copy(std::begin(view.viewRange), std::end(view.viewRange), pushConstants.viewRange);
+        pushConstants.level = view.tileLevel;
+        pushConstants.tilesPerFormat = _tileSlotsPerPool;
+        pushConstants.tileCount = _tileSlotsPerPool * static_cast<uint32_t>(PlotVertexFormat::Count);
+        pushConstants.sampleCount = _tileSampleCount;
+        pushConstants.tilesPerChunk = _tilesPerChunk;
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipeline);
+        VkDescriptorSet descriptorSets[] = {_descriptorSet, _cullDescriptorSets[viewIndex]};
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipelineLayout, 0, 2, descriptorSets, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, _cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &pushConstants);
+        vkCmdDispatch(commandBuffer, (pushConstants.tileCount + 63) / 64, 1, 1);
+    }
+
+
+    // The graphics queue's family and those of the async queues, without duplicates
+    std::vector<uint32_t> _getQueueFamilies()
+    {
+        std::vector<uint32_t> queueFamilies = {_graphicsQueueFamily};
+        for (const AsyncQueue& asyncQueue : _asyncQueues) {
+            if (asyncQueue.queue != VK_NULL_HANDLE && std::find(queueFamilies.begin(), queueFamilies.end(), asyncQueue.family) == queueFamilies.end()) {
+                queueFamilies.push_back(asyncQueue.family);
+            }
+        }
+        return queueFamilies;
+    }
+
+
+    uint32_t _findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+    {
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(_physicalDevice, &memoryProperties);
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+        throw std::runtime_error("Failed to find a suitable memory type");
+    }
+
+
+    // Buffers the render graph hands between queues are shared by all the queue families it uses, so they don't
+    // need ownership transfers on the way
+    void _createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory, bool sharedAcrossQueues = false)
+    {
+        VkBufferCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        createInfo.size = size;
+        createInfo.usage = usage;
+        createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        std::vector<uint32_t> queueFamilies = _getQueueFamilies();
+        if (sharedAcrossQueues && queueFamilies.size() > 1) {
+            createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+            createInfo.pQueueFamilyIndices = queueFamilies.data();
+        }
+        if (vkCreateBuffer(_device, &createInfo, nullptr, &buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create buffer");
+        }
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetBufferMemoryRequirements(_device, buffer, &memoryRequirements);
+
+        VkMemoryAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = memoryRequirements.size;
+        allocateInfo.memoryTypeIndex = _findMemoryType(memoryRequirements.memoryTypeBits, properties);
+        if (vkAllocateMemory(_device, &allocateInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate buffer memory");
+        }
+        vkBindBufferMemory(_device, buffer, bufferMemory, 0);
+    }
+
+
+    // Each tile pool is split into fixed size slots, one per resident tile, in chunks of _tilesPerChunk. Tiles get
+    // encoded straight into the matching slot of their chunk's staging buffer and copied across when recording.
+    // No memory is allocated here, the chunks are allocated as the slots get used.
+    void _createTilePools()
+    {
+        for (uint32_t format = 0; format < static_cast<uint32_t>(PlotVertexFormat::Count); format++) {
+            PlotTilePool& pool = _tilePools[format];
+            pool.vertexSize = static_cast<PlotVertexFormat>(format) == PlotVertexFormat::Packed16 ? sizeof(PackedFunctionVertex) : sizeof(FunctionVertex);
+            pool.chunks.resize(_getTileChunkCount());
+            for (uint32_t slot = 0; slot < _maxResidentTiles; slot++) {
+                pool.freeSlots.insert(slot);
+            }
+        }
+        for (uint32_t slot = _maxResidentTiles; slot < _tileSlotsPerPool; slot++) {
+            _freeReservedTileSlots.insert(slot);
+        }
+        _tileColumns.resize((1 + PlotFunction::maxTerms) * _tileSampleCount);
+    }
+
+
+    uint32_t _getTileChunkCount() const
+    {
+        return (_tileSlotsPerPool + _tilesPerChunk - 1) / _tilesPerChunk;
+    }
+
 
-        VkDeviceCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        createInfo.pQueueCreateInfos = queueCreateInfos.data();
-        createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
-        createInfo.pEnabledFeatures = &physicalDeviceFeatures;
+    void _allocateTileChunk(PlotTilePool& pool, PlotTileChunk& chunk)
+    {
+        VkDeviceSize bufferSize = pool.vertexSize * _tileSampleCount * _tilesPerChunk;
+        _createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, chunk.vertexBuffer, chunk.vertexBufferMemory, true);
+        _createBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, chunk.stagingBuffer, chunk.stagingBufferMemory, true);
+        vkMapMemory(_device, chunk.stagingBufferMemory, 0, bufferSize, 0, &chunk.pStagingData);
+        _tileChunkMemory += bufferSize;
+    }
 
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(_deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = _deviceExtensions.data();
 
-        if (_enableValidationLayers) {
-            createInfo.enabledLayerCount = static_cast<uint32_t>(_validationLayers.size());
-            createInfo.ppEnabledLayerNames = _validationLayers.data();
-        } else {
-            createInfo.enabledLayerCount = 0;
+    // Only called between the fence wait and recording, when the GPU is done with the chunk
+    void _freeTileChunk(PlotTilePool& pool, PlotTileChunk& chunk)
+    {
+        if (chunk.vertexBuffer == VK_NULL_HANDLE) {
+            return;
         }
-        VkResult deviceCreateResult = vkCreateDevice(_physicalDevice, &createInfo, nullptr, &_device);
-        if (deviceCreateResult != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create logical device.\n");
+        vkUnmapMemory(_device, chunk.stagingBufferMemory);
+        vkDestroyBuffer(_device, chunk.stagingBuffer, nullptr);
+        vkFreeMemory(_device, chunk.stagingBufferMemory, nullptr);
+        vkDestroyBuffer(_device, chunk.vertexBuffer, nullptr);
+        vkFreeMemory(_device, chunk.vertexBufferMemory, nullptr);
+        _tileChunkMemory -= pool.vertexSize * _tileSampleCount * _tilesPerChunk;
+        chunk = PlotTileChunk{};
+    }
+
+
+    uint8_t* _getStagingVertices(PlotVertexFormat format, uint32_t slot)
+    {
+        PlotTilePool& pool = _tilePools[static_cast<size_t>(format)];
+        PlotTileChunk& chunk = pool.chunks[slot / _tilesPerChunk];
+        return static_cast<uint8_t*>(chunk.pStagingData) + pool.vertexSize * _tileSampleCount * (slot % _tilesPerChunk);
+    }
+
+
+    // The slot's staging data gets copied to the device when the next frame is recorded
+    void _queueTileUpload(PlotVertexFormat format, uint32_t slot)
+    {
+        PlotTilePool& pool = _tilePools[static_cast<size_t>(format)];
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = pool.vertexSize * _tileSampleCount * (slot % _tilesPerChunk);
+        copyRegion.dstOffset = copyRegion.srcOffset;
+        copyRegion.size = pool.vertexSize * _tileSampleCount;
+        pool.chunks[slot / _tilesPerChunk].pendingCopies.push_back(copyRegion);
+    }
+
+
+    // Per tile and per function data is written straight from the CPU into mapped memory, and shared with the async
+    // queues for the cull pass. The draw commands and counts are the render graph's, made fresh every frame.
+    // The index buffer is just 0..N-1, shared by every tile.
+    void _createPlotBuffers()
+    {
+        VkDeviceSize tileDataSize = sizeof(GpuPlotTile) * _tileSlotsPerPool * static_cast<uint32_t>(PlotVertexFormat::Count);
+        _createBuffer(tileDataSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _tileDataBuffer, _tileDataBufferMemory, true);
+        vkMapMemory(_device, _tileDataBufferMemory, 0, tileDataSize, 0, reinterpret_cast<void**>(&_pTileData));
+        std::fill(_pTileData, _pTileData + _tileSlotsPerPool * static_cast<uint32_t>(PlotVertexFormat::Count), GpuPlotTile{});
+
+        VkDeviceSize functionDataSize = sizeof(GpuPlotFunction) * (_maxPlotFunctions + _maxReservedFunctions);
+        _createBuffer(functionDataSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _functionDataBuffer, _functionDataBufferMemory, true);
+        vkMapMemory(_device, _functionDataBufferMemory, 0, functionDataSize, 0, reinterpret_cast<void**>(&_pFunctionData));
+
+        std::vector<uint32_t> indices(_tileSampleCount);
+        for (uint32_t i = 0; i < _tileSampleCount; i++) {
+            indices[i] = i;
         }
+        VkDeviceSize indexBufferSize = sizeof(uint32_t) * indices.size();
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        _createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+        void* pData;
+        vkMapMemory(_device, stagingBufferMemory, 0, indexBufferSize, 0, &pData);
+        std::memcpy(pData, indices.data(), indexBufferSize);
+        vkUnmapMemory(_device, stagingBufferMemory);
+        _createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _indexBuffer, _indexBufferMemory);
+        _copyBuffer(stagingBuffer, _indexBuffer, indexBufferSize);
+        vkDestroyBuffer(_device, stagingBuffer, nullptr);
+        vkFreeMemory(_device, stagingBufferMemory, nullptr);
+    }
 
-        vkGetDeviceQueue(_device, indices.graphicsFamily.value(), 0, &_graphicsQueue);
-        vkGetDeviceQueue(_device, indices.presentFamily.value(), 0, &_presentQueue);
 
-        std::cout << "successfullly created logical device!\n";
+    void _createExpressionBuffer()
+    {
+        _createBuffer(sizeof(GpuExpression), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _expressionBuffer, _expressionBufferMemory);
+        vkMapMemory(_device, _expressionBufferMemory, 0, sizeof(GpuExpression), 0, reinterpret_cast<void**>(&_pExpressionData));
+        *_pExpressionData = GpuExpression{};
     }
 
 
-    void _createSurface()
+    // The atlas never changes after startup, so it's uploaded once and left in the shader read layout
+    void _createGlyphAtlasImage()
     {
-        if (!SDL_Vulkan_CreateSurface(_pWindow, _instance, nullptr, &_surface)) {
-            throw std::runtime_error("Failed to create window surface.\n");
+        uint32_t width = _glyphAtlas.getWidth();
+        uint32_t height = _glyphAtlas.getHeight();
+        VkDeviceSize imageSize = _glyphAtlas.getPixels().size();
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        _createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+        void* pData;
+        vkMapMemory(_device, stagingBufferMemory, 0, imageSize, 0, &pData);
+        std::memcpy(pData, _glyphAtlas.getPixels().data(), imageSize);
+        vkUnmapMemory(_device, stagingBufferMemory);
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = VK_FORMAT_R8_UNORM;
+        imageInfo.extent = {width, height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        if (vkCreateImage(_device, &imageInfo, nullptr, &_glyphAtlasImage) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create glyph atlas image");
+        }
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetImageMemoryRequirements(_device, _glyphAtlasImage, &memoryRequirements);
+        VkMemoryAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocateInfo.allocationSize = memoryRequirements.size;
+        allocateInfo.memoryTypeIndex = _findMemoryType(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (vkAllocateMemory(_device, &allocateInfo, nullptr, &_glyphAtlasImageMemory) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate glyph atlas memory");
+        }
+        vkBindImageMemory(_device, _glyphAtlasImage, _glyphAtlasImageMemory, 0);
+
+        VkCommandBuffer commandBuffer = _beginOneTimeCommands();
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = _glyphAtlasImage;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy copyRegion{};
+        copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copyRegion.imageSubresource.layerCount = 1;
+        copyRegion.imageExtent = {width, height, 1};
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, _glyphAtlasImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
+
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        _endOneTimeCommands(commandBuffer);
+        vkDestroyBuffer(_device, stagingBuffer, nullptr);
+        vkFreeMemory(_device, stagingBufferMemory, nullptr);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = _glyphAtlasImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R8_UNORM;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(_device, &viewInfo, nullptr, &_glyphAtlasImageView) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create glyph atlas image view");
+        }
+
+        // Linear filtering is what makes the distance field work, clamping stops cells bleeding into each other at the atlas edges
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.maxLod = 0.0f;
+        if (vkCreateSampler(_device, &samplerInfo, nullptr, &_glyphAtlasSampler) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create glyph atlas sampler");
         }
+        std::cout << "Glyph atlas: " << width << "x" << height << "\n";
     }
 
 
-    bool _checkDeviceExtensionSupport(VkPhysicalDevice device)
+    // Written from the CPU like the tile data, each view has its own fixed part of it
+    void _createGlyphInstanceBuffer()
     {
-        uint32_t extensionCount = 0;
-        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
-        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
-        std::set<std::string> requiredExtensions(_deviceExtensions.begin(), _deviceExtensions.end());
-        std::cout << "\nAvailable device extensions:\n";
-        for (const VkExtensionProperties& extension : availableExtensions) {
-            std::cout << "\t" << extension.extensionName << "\n";
-            requiredExtensions.erase(extension.extensionName);
+        VkDeviceSize bufferSize = sizeof(GpuGlyphInstance) * _maxGlyphInstances * _maxViews;
+        _createBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _glyphInstanceBuffer, _glyphInstanceBufferMemory);
+        vkMapMemory(_device, _glyphInstanceBufferMemory, 0, bufferSize, 0, reinterpret_cast<void**>(&_pGlyphInstances));
+    }
+
+
+    // Changing the expression only rewrites the uniform buffer, nothing gets recompiled or re-meshed.
+    // Has to run after the fence wait since the previous frame reads the same buffer.
+    void _updateDomainExpression()
+    {
+        if (!_pendingDomainExpression.has_value()) {
+            return;
         }
-        return requiredExtensions.empty();
+        try {
+            std::vector<ExpressionInstruction> instructions = ExpressionCompiler().compile(*_pendingDomainExpression, {"z"});
+            _pExpressionData->instructionCount = static_cast<uint32_t>(instructions.size());
+            std::copy(instructions.begin(), instructions.end(), _pExpressionData->instructions);
+            std::cout << "Domain coloring f(z) = " << *_pendingDomainExpression << "\n";
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+        }
+        _pendingDomainExpression.reset();
     }
 
 
-    SwapChainSupportDetails _querySwapChainSupport(VkPhysicalDevice device)
+    void _copyBuffer(VkBuffer sourceBuffer, VkBuffer destinationBuffer, VkDeviceSize size)
     {
-        SwapChainSupportDetails details;
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, _surface, &details.capabilities);
+        VkCommandBuffer commandBuffer = _beginOneTimeCommands();
+        VkBufferCopy copyRegion{};
+        copyRegion.size = size;
+        vkCmdCopyBuffer(commandBuffer, sourceBuffer, destinationBuffer, 1, &copyRegion);
+        _endOneTimeCommands(commandBuffer);
+    }
 
-        uint32_t formatCount = 0;
-        vkGetPhysicalDeviceSurfaceFormatsKHR(device, _surface, &formatCount, nullptr);
-        if (formatCount != 0) {
-            details.formats.resize(formatCount);
-            vkGetPhysicalDeviceSurfaceFormatsKHR(device, _surface, &formatCount, details.formats.data());
+
+    // For uploads at startup, which wait for the queue to go idle
+    VkCommandBuffer _beginOneTimeCommands()
+    {
+        VkCommandBufferAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandPool = _commandPool;
+        allocateInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer;
+        vkAllocateCommandBuffers(_device, &allocateInfo, &commandBuffer);
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        return commandBuffer;
+    }
+
+
+    void _endOneTimeCommands(VkCommandBuffer commandBuffer)
+    {
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        vkQueueSubmit(_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(_graphicsQueue);
+        vkFreeCommandBuffers(_device, _commandPool, 1, &commandBuffer);
+    }
+
+
+    void _createDescriptorPool()
+    {
+        VkDescriptorPoolSize poolSizes[3]{};
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[0].descriptorCount = 3 + 2 * _maxViews;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        poolSizes[1].descriptorCount = 1;
+        poolSizes[2].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[2].descriptorCount = 1;
+
+        VkDescriptorPoolCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        createInfo.poolSizeCount = 3;
+        createInfo.pPoolSizes = poolSizes;
+        createInfo.maxSets = 1 + _maxViews;
+        if (vkCreateDescriptorPool(_device, &createInfo, nullptr, &_descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create descriptor pool");
         }
+    }
 
-        uint32_t presentModeCount = 0;
-        vkGetPhysicalDeviceSurfacePresentModesKHR(device, _surface, &presentModeCount, details.presentModes.data());
-        if (presentModeCount != 0) {
-            details.presentModes.resize(presentModeCount);
-            vkGetPhysicalDeviceSurfacePresentModesKHR(device, _surface, &presentModeCount, details.presentModes.data());
+
+    void _createDescriptorSet()
+    {
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = _descriptorPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &_descriptorSetLayout;
+        if (vkAllocateDescriptorSets(_device, &allocateInfo, &_descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate descriptor set");
         }
 
-        return details;
+        VkBuffer buffers[] = {_tileDataBuffer, _functionDataBuffer, _expressionBuffer, _glyphInstanceBuffer};
+        const uint32_t bindingNumbers[] = {0, 1, 4, 5};
+        VkDescriptorBufferInfo bufferInfos[4]{};
+        VkWriteDescriptorSet descriptorWrites[5]{};
+        for (uint32_t i = 0; i < 4; i++) {
+            bufferInfos[i].buffer = buffers[i];
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range = VK_WHOLE_SIZE;
+            descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[i].dstSet = _descriptorSet;
+            descriptorWrites[i].dstBinding = bindingNumbers[i];
+            descriptorWrites[i].dstArrayElement = 0;
+            descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[i].descriptorCount = 1;
+            descriptorWrites[i].pBufferInfo = &bufferInfos[i];
+        }
+        descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.sampler = _glyphAtlasSampler;
+        imageInfo.imageView = _glyphAtlasImageView;
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[4].dstSet = _descriptorSet;
+        descriptorWrites[4].dstBinding = 6;
+        descriptorWrites[4].dstArrayElement = 0;
+        descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[4].descriptorCount = 1;
+        descriptorWrites[4].pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(_device, 5, descriptorWrites, 0, nullptr);
+
+        // The cull sets are only written once the frame's render graph has its draw buffers, see _writeCullDescriptorSets
+        std::vector<VkDescriptorSetLayout> cullSetLayouts(_maxViews, _cullDescriptorSetLayout);
+        _cullDescriptorSets.resize(_maxViews);
+        allocateInfo.descriptorSetCount = _maxViews;
+        allocateInfo.pSetLayouts = cullSetLayouts.data();
+        if (vkAllocateDescriptorSets(_device, &allocateInfo, _cullDescriptorSets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate cull descriptor sets");
+        }
     }
 
 
-    VkSurfaceFormatKHR _chooseSwapSurfaceFormat(std::vector<VkSurfaceFormatKHR>& availableFormats)
+    // Only between frames, the sets can't change while a command buffer that binds them is still pending
+    void _writeCullDescriptorSets(const RenderGraph& graph, const std::vector<std::pair<RenderGraph::Resource, RenderGraph::Resource>>& drawBuffers)
     {
-        for (const auto& availableFormat : availableFormats) {
-            if (availableFormat.format == VK_FORMAT_R8G8B8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
-                return availableFormat;
-            }
+        std::vector<VkDescriptorBufferInfo> bufferInfos(drawBuffers.size() * 2);
+        std::vector<VkWriteDescriptorSet> descriptorWrites(drawBuffers.size() * 2);
+        for (size_t i = 0; i < bufferInfos.size(); i++) {
+            const auto& [drawCommands, drawCounts] = drawBuffers[i / 2];
+            bufferInfos[i].buffer = graph.getBuffer(i % 2 == 0 ? drawCommands : drawCounts);
+            bufferInfos[i].offset = 0;
+            bufferInfos[i].range = VK_WHOLE_SIZE;
+            descriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[i].dstSet = _cullDescriptorSets[i / 2];
+            descriptorWrites[i].dstBinding = static_cast<uint32_t>(i % 2);
+            descriptorWrites[i].dstArrayElement = 0;
+            descriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[i].descriptorCount = 1;
+            descriptorWrites[i].pBufferInfo = &bufferInfos[i];
         }
-        return availableFormats[0];
+        vkUpdateDescriptorSets(_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
     }
 
 
-    VkPresentModeKHR _chooseSwapPresentMode(std::vector<VkPresentModeKHR>& availablePresentModes)
+    // Timestamps are optional. timestampComputeAndGraphics only promises them on every graphics and compute queue,
+    // without it the graphics queue family's timestampValidBits says whether it has them, 0 meaning it doesn't.
+    void _createTimestampQueryPool()
     {
-        for (const auto& presentMode : availablePresentModes) {
-            if (presentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-                return presentMode;
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(_physicalDevice, &properties);
+        _timestampPeriod = properties.limits.timestampPeriod;
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(_physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(_physicalDevice, &queueFamilyCount, queueFamilies.data());
+        uint32_t validBits = queueFamilies[_graphicsQueueFamily].timestampValidBits;
+        _timestampsSupported = validBits > 0;
+        _timestampMask = validBits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t{1} << validBits) - 1;
+        if (!_timestampsSupported) {
+            std::cout << "The graphics queue has no timestamps, plot GPU times won't be measured\n";
+        }
+
+        VkQueryPoolCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        createInfo.queryCount = 2;
+        if (vkCreateQueryPool(_device, &createInfo, nullptr, &_timestampQueryPool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create timestamp query pool");
+        }
+    }
+
+
+    void _createSyncObjects()
+    {
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // So the first frame doesn't wait forever
+        if (vkCreateFence(_device, &fenceInfo, nullptr, &_inFlightFence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create synchronisation objects");
+        }
+
+        // One per async queue, counting its submits. The queues after it in a frame wait for the value it signalled.
+        VkSemaphoreTypeCreateInfo semaphoreTypeInfo{};
+        semaphoreTypeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        semaphoreTypeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        semaphoreTypeInfo.initialValue = 0;
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &semaphoreTypeInfo;
+        for (AsyncQueue& asyncQueue : _asyncQueues) {
+            if (asyncQueue.queue != VK_NULL_HANDLE && vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &asyncQueue.timelineSemaphore) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create synchronisation objects");
             }
         }
-        return VK_PRESENT_MODE_FIFO_KHR;
     }
 
 
-    VkExtent2D _chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
+    void _createViewSemaphores(PlotView& view)
     {
-        if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
-            return capabilities.currentExtent;
-        } else {
-            int width, height;
-            SDL_GetWindowSizeInPixels(_pWindow, &width, &height);
-            VkExtent2D actualExtent = {
-                static_cast<uint32_t>(width),
-                static_cast<uint32_t>(height)
-            };
-            actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.height);
-            actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
-            return actualExtent;
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        if (vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &view.imageAvailableSemaphore) != VK_SUCCESS ||
+            vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &view.renderFinishedSemaphore) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create synchronisation objects");
         }
     }
 
 
-    void _createSwapChain()
+    // Works out which tiles are visible and evaluates the ones that aren't resident yet, or whose function
+    // changed structure since they were evaluated. Coefficient changes don't show up here at all.
+    // Only runs when the visible tile range or a function's structure changed, otherwise the resident tiles are still right.
+    // Every view can be at a different level and range, the tiles any of them need are resident at the same time.
+    void _updatePlotTiles()
     {
-        SwapChainSupportDetails swapchainSupport = _querySwapChainSupport(_physicalDevice);
-        VkSurfaceFormatKHR surfaceFormat = _chooseSwapSurfaceFormat(swapchainSupport.formats);
-        VkPresentModeKHR presentMode = _chooseSwapPresentMode(swapchainSupport.presentModes);
-        VkExtent2D extent = _chooseSwapExtent(swapchainSupport.capabilities);
+        TileViewState viewState{};
+        for (PlotView& view : _views) {
+            float viewWidth = view.viewRange[1] - view.viewRange[0];
+            view.tileLevel = static_cast<int32_t>(std::ceil(std::log2(viewWidth / _tilesAcrossView)));
+            float tileWidth = std::ldexp(1.0f, view.tileLevel);
+            int64_t firstIndex = static_cast<int64_t>(std::floor(view.viewRange[0] / tileWidth));
+            int64_t lastIndex = static_cast<int64_t>(std::floor(view.viewRange[1] / tileWidth));
+            viewState.viewTiles.push_back({view.tileLevel, firstIndex, lastIndex});
+        }
 
-        uint32_t imageCount = swapchainSupport.capabilities.minImageCount + 1;
-        // a maxImageCount of 0 means there is no maximum. So this is 'if (there is a maximum) and (imageCount is greater than it)'
-        if (swapchainSupport.capabilities.maxImageCount > 0 && imageCount > swapchainSupport.capabilities.maxImageCount) {
-            imageCount = swapchainSupport.capabilities.maxImageCount;
+        // Revisions only ever go up, so any structural change shows up in the sum
+        uint64_t revisionSum = 0;
+        for (const PlotFunction* pFunction : _plotFunctions) {
+            revisionSum += pFunction->getStructureRevision();
+        }
+        viewState.functionCount = _plotFunctions.size();
+        viewState.revisionSum = revisionSum;
+        if (_lastTileViewState == viewState) {
+            return;
+        }
+        _lastTileViewState = viewState;
+
+        // Mark everything that's still valid first, so making room for the missing tiles can't evict a visible one
+        std::vector<std::pair<PlotTileKey, uint32_t>> missingTiles;
+        std::set<PlotTileKey> missingKeys; // Views at the same level can overlap
+        for (uint32_t functionIndex = 0; functionIndex < _plotFunctions.size(); functionIndex++) {
+            const PlotFunction* pFunction = _plotFunctions[functionIndex];
+            for (const auto& [level, firstIndex, lastIndex] : viewState.viewTiles) {
+                for (int64_t index = firstIndex; index <= lastIndex; index++) {
+                    PlotTileKey key = {pFunction, level, index};
+                    auto it = _residentTiles.find(key);
+                    if (it != _residentTiles.end() && it->second.structureRevision == pFunction->getStructureRevision()) {
+                        it->second.lastUsedFrame = _frameNumber;
+                    } else if (missingKeys.insert(key).second) {
+                        missingTiles.push_back({key, functionIndex});
+                    }
+                }
+            }
         }
-        
-        VkSwapchainCreateInfoKHR createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-        createInfo.surface = _surface;
-        createInfo.minImageCount = imageCount;
-        createInfo.imageFormat = surfaceFormat.format;
-        createInfo.imageColorSpace = surfaceFormat.colorSpace;
-        createInfo.imageExtent = extent;
-        createInfo.imageArrayLayers = 1;
-        createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-        QueueFamilyIndices indices = _findQueueFamilies(_physicalDevice);
-        uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
-        if (indices.graphicsFamily != indices.presentFamily) {
-            createInfo.imageSharingMode = VK_SHARING_MODE_CONCURRENT;
-            createInfo.queueFamilyIndexCount = 2;
-            createInfo.pQueueFamilyIndices = queueFamilyIndices;
-        } else {
-            createInfo.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-            createInfo.queueFamilyIndexCount = 0; // optional.
-            createInfo.pQueueFamilyIndices = nullptr; // optional.
+        // Evicting in one go per format, rather than a search of every resident tile for each missing one
+        uint32_t newSlotCounts[static_cast<size_t>(PlotVertexFormat::Count)] = {};
+        for (const auto& [key, functionIndex] : missingTiles) {
+            auto it = _residentTiles.find(key);
+            if (it == _residentTiles.end() || it->second.format != key.pFunction->getVertexFormat()) {
+                newSlotCounts[static_cast<size_t>(key.pFunction->getVertexFormat())]++;
+            }
         }
-        createInfo.preTransform = swapchainSupport.capabilities.currentTransform;
-        createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-        createInfo.presentMode = presentMode;
-        createInfo.clipped = VK_TRUE;
-        createInfo.oldSwapchain = VK_NULL_HANDLE;
-        
-        VkResult result = vkCreateSwapchainKHR(_device, &createInfo, nullptr, &_swapchain);
-        if (result != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create swapchain.\n");
+        for (uint32_t format = 0; format < static_cast<uint32_t>(PlotVertexFormat::Count); format++) {
+            uint32_t usedSlots = _maxResidentTiles - static_cast<uint32_t>(_tilePools[format].freeSlots.size());
+            if (usedSlots + newSlotCounts[format] > _tileResidencyLimit) {
+                _evictTiles(static_cast<PlotVertexFormat>(format), usedSlots + newSlotCounts[format] - _tileResidencyLimit);
+            }
+        }
+
+        for (const auto& [key, functionIndex] : missingTiles) {
+            PlotVertexFormat format = key.pFunction->getVertexFormat();
+            auto it = _residentTiles.find(key);
+            uint32_t slot;
+            if (it != _residentTiles.end() && it->second.format == format) {
+                slot = it->second.slot;
+            } else {
+                if (it != _residentTiles.end()) {
+                    _releaseTile(it);
+                }
+                std::optional<uint32_t> freeSlot = _acquireTileSlot(format);
+                if (!freeSlot.has_value()) {
+                    // Only drawing less, the tile gets another go the next time the visible tiles change
+                    _frameStats.tilesSkipped++;
+                    continue;
+                }
+                slot = *freeSlot;
+            }
+
+            ResidentPlotTile tile{};
+            tile.slot = slot;
+            tile.format = format;
+            tile.structureRevision = key.pFunction->getStructureRevision();
+            tile.lastUsedFrame = _frameNumber;
+            _residentTiles[key] = tile;
+            if (_restoreTile(key, tile, functionIndex)) {
+                continue;
+            }
+
+            float tileWidth = std::ldexp(1.0f, key.level);
+            float xStart = key.index * tileWidth;
+            float xEnd = (key.index + 1) * tileWidth;
+            key.pFunction->evaluateTile(xStart, xEnd, _tileSampleCount, _tileColumns.data());
+            // Quantizing needs a finite range, so tiles running into a pole or out of a function's domain stay floats
+            if (format == PlotVertexFormat::Packed16 && !std::all_of(_tileColumns.begin(), _tileColumns.end(), [](float value) { return std::isfinite(value); })) {
+                std::optional<uint32_t> floatSlot = _acquireTileSlot(PlotVertexFormat::Float32);
+                _releaseTile(_residentTiles.find(key));
+                if (!floatSlot.has_value()) {
+                    _frameStats.tilesSkipped++;
+                    continue;
+                }
+                format = PlotVertexFormat::Float32;
+                slot = *floatSlot;
+                tile.format = format;
+                tile.slot = slot;
+                _residentTiles[key] = tile;
+            }
+            GpuPlotTile* pGpuTile = _getGpuTile(format, slot);
+            std::chrono::steady_clock::time_point encodeStart = std::chrono::steady_clock::now();
+            _encodeTile(format, slot, pGpuTile);
+            _tileEncodeTime += std::chrono::steady_clock::now() - encodeStart;
+            _tileEncodeVertexCount += _tileSampleCount;
+            pGpuTile->xRange[0] = xStart;
+            pGpuTile->xRange[1] = xEnd;
+            pGpuTile->functionIndex = functionIndex;
+            pGpuTile->level = key.level;
+            pGpuTile->slot = slot;
+            pGpuTile->format = static_cast<uint32_t>(format);
+            pGpuTile->resident = 1;
+            pGpuTile->flags = 0;
+            _frameStats.tilesEvaluated++;
         }
+    }
 
-        vkGetSwapchainImagesKHR(_device, _swapchain, &imageCount, nullptr);
-        _swapchainImages.resize(imageCount);
-        vkGetSwapchainImagesKHR(_device, _swapchain, &imageCount, _swapchainImages.data());
 
-        _swapchainImageFormat = surfaceFormat.format;
-        _swapchainExtent = extent;
+    // Rebuilds each data plot's tiles from the pyramid level matching the current zoom, whenever the x range changed
+    void _updateDataPlots()
+    {
+        const uint32_t verticesPerTile = _tileSampleCount - 1;
+        for (DataPlot& plot : _dataPlots) {
+            std::pair<float, float> xRange = {_views[0].viewRange[0], _views[0].viewRange[1]};
+            if (plot.builtXRange == xRange) {
+                continue;
+            }
+            plot.builtXRange = xRange;
 
-        std::cout << "successfully created swapchain!\n";
+            _dataVertices.clear();
+            uint32_t maxVertexCount = static_cast<uint32_t>(plot.slots.size()) * verticesPerTile + 1;
+            plot.source.buildVertices(xRange.first, xRange.second, maxVertexCount, &_dataVertices);
+            _frameStats.dataVerticesStreamed += static_cast<uint32_t>(_dataVertices.size());
+            _writeStripTiles({&_dataVertices, 1}, plot.slots, plot.functionIndex);
+        }
     }
 
 
-    void _createImageViews()
+    void _updateImplicitPlots()
     {
-        _swapchainImageViews.resize(_swapchainImages.size());
-        for (uint32_t i = 0; i < _swapchainImages.size(); i++) {
-            VkImageViewCreateInfo createInfo{};
-            createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-            createInfo.image = _swapchainImages[i];
-            createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-            createInfo.format = _swapchainImageFormat;
-            createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-            createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-            createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-            createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-            createInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            createInfo.subresourceRange.baseMipLevel = 0;
-            createInfo.subresourceRange.levelCount = 1;
-            createInfo.subresourceRange.baseArrayLayer = 0;
-            createInfo.subresourceRange.layerCount = 1;
+        const PlotView& view = _views[0];
+        std::array<float, 4> viewRange = {view.viewRange[0], view.viewRange[1], view.viewRange[2], view.viewRange[3]};
+        for (ImplicitPlot& plot : _implicitPlots) {
+            if (plot.builtViewRange == viewRange) {
+                continue;
+            }
+            plot.builtViewRange = viewRange;
 
-            if (vkCreateImageView(_device, &createInfo, nullptr, &_swapchainImageViews[i]) != VK_SUCCESS) {
-                throw std::runtime_error("Failed to create image views!\n");
+            ContourGrid grid = {
+                viewRange[0], viewRange[1], viewRange[2], viewRange[3],
+                std::max(1u, view.swapchainExtent.width / 2), std::max(1u, view.swapchainExtent.height / 2)
+            };
+            std::vector<std::vector<FunctionVertex>> polylines = _contourExtractor.extract(plot.program, grid);
+            _frameStats.contourCellsEvaluated += grid.cellsX * grid.cellsY;
+
+            uint32_t tileCount = 0;
+            for (const std::vector<FunctionVertex>& polyline : polylines) {
+                tileCount += static_cast<uint32_t>((std::max<size_t>(polyline.size(), 1) - 1 + _tileSampleCount - 2) / (_tileSampleCount - 1));
             }
+            _resizeReservedTileSlots(&plot.slots, tileCount);
+            _frameStats.contourVerticesDropped += static_cast<uint32_t>(_writeStripTiles(polylines, plot.slots, plot.functionIndex));
         }
     }
 
 
-    void _createGraphicsPipeline()
+    // Gives back the slots past count, or takes more from the reserved region for as long as there are any left
+    void _resizeReservedTileSlots(std::vector<uint32_t>* pSlots, uint32_t count)
+    {
+        while (pSlots->size() > count) {
+            _freeTileSlot(PlotVertexFormat::Float32, pSlots->back());
+            pSlots->pop_back();
+        }
+        PlotTilePool& pool = _tilePools[static_cast<size_t>(PlotVertexFormat::Float32)];
+        while (pSlots->size() < count && !_freeReservedTileSlots.empty()) {
+            pSlots->push_back(*_freeReservedTileSlots.begin());
+            _freeReservedTileSlots.erase(_freeReservedTileSlots.begin());
+            _useTileSlot(pool, pSlots->back());
+        }
+    }
+
+
+    // Cuts each strip into line strip tiles over the given slots. Neighbouring tiles of a strip share their edge
+    // vertex so they join up, and a strip's last tile repeats its final vertex to fill up, which draws nothing.
+    // Slots left over are made non-resident. Returns how many vertices didn't fit.
+    size_t _writeStripTiles(std::span<const std::vector<FunctionVertex>> strips, const std::vector<uint32_t>& slots, uint32_t functionIndex)
     {
-        std::vector<char> vertShaderCode = _readFile("shaders/vert.spv");
-        std::vector<char> fragShaderCode = _readFile("shaders/frag.spv");
+        const uint32_t verticesPerTile = _tileSampleCount - 1;
+        size_t slotIndex = 0;
+        size_t droppedVertexCount = 0;
+        float* pX = _tileColumns.data();
+        for (const std::vector<FunctionVertex>& strip : strips) {
+            for (size_t firstVertex = 0; firstVertex + 1 < strip.size(); firstVertex += verticesPerTile) {
+                if (slotIndex == slots.size()) {
+                    droppedVertexCount += strip.size() - firstVertex;
+                    break;
+                }
+                uint32_t slot = slots[slotIndex++];
+                GpuPlotTile* pGpuTile = _getGpuTile(PlotVertexFormat::Float32, slot);
+                std::fill(_tileColumns.begin(), _tileColumns.end(), 0.0f);
+                for (uint32_t i = 0; i < _tileSampleCount; i++) {
+                    const FunctionVertex& vertex = strip[std::min(firstVertex + i, strip.size() - 1)];
+                    pX[i] = vertex.x;
+                    pX[_tileSampleCount + i] = vertex.basis[0];
+                }
+                _encodeTile(PlotVertexFormat::Float32, slot, pGpuTile);
+                auto [xMin, xMax] = std::minmax_element(pX, pX + _tileSampleCount);
+                pGpuTile->xRange[0] = *xMin;
+                pGpuTile->xRange[1] = *xMax;
+                pGpuTile->functionIndex = functionIndex;
+                pGpuTile->level = 0;
+                pGpuTile->slot = slot;
+                pGpuTile->format = static_cast<uint32_t>(PlotVertexFormat::Float32);
+                pGpuTile->resident = 1;
+                pGpuTile->flags = GPU_PLOT_TILE_ANY_LEVEL;
+            }
+        }
+        for (; slotIndex < slots.size(); slotIndex++) {
+            _getGpuTile(PlotVertexFormat::Float32, slots[slotIndex])->resident = 0;
+        }
+        return droppedVertexCount;
+    }
 
-        VkShaderModule vertShaderModule = _createShaderModule(vertShaderCode);
-        VkShaderModule fragShaderModule = _createShaderModule(fragShaderCode);
 
-        VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-        vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-        vertShaderStageInfo.module = vertShaderModule;
-        vertShaderStageInfo.pName = "main";
+    // Steps of 1, 2 or 5 times a power of ten, about one label per _pixelsPerTick on each axis
+    AxisTicks _computeAxisTicks(const PlotView& view)
+    {
+        AxisTicks ticks{};
+        uint32_t viewportSize[2] = {view.swapchainExtent.width, view.swapchainExtent.height};
+        for (uint32_t axis = 0; axis < 2; axis++) {
+            double minimum = view.viewRange[2 * axis];
+            double maximum = view.viewRange[2 * axis + 1];
+            double rawStep = (maximum - minimum) / std::max(1.0, static_cast<double>(viewportSize[axis] / _pixelsPerTick));
+            double magnitude = std::pow(10.0, std::floor(std::log10(rawStep)));
+            double normalised = rawStep / magnitude;
+            double multiple = normalised < 1.5 ? 1.0 : normalised < 3.5 ? 2.0 : normalised < 7.5 ? 5.0 : 10.0;
+            ticks.step[axis] = multiple * magnitude;
+            ticks.first[axis] = static_cast<int64_t>(std::ceil(minimum / ticks.step[axis]));
+            ticks.last[axis] = static_cast<int64_t>(std::floor(maximum / ticks.step[axis]));
+        }
+        return ticks;
+    }
 
-        VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-        fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        fragShaderStageInfo.module = fragShaderModule;
-        fragShaderStageInfo.pName = "main";
 
-        VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-        
-        VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-        vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 0;
-        vertexInputInfo.vertexAttributeDescriptionCount = 0;
-        vertexInputInfo.pVertexAttributeDescriptions = nullptr;
-        vertexInputInfo.pVertexBindingDescriptions = nullptr;
+    // As many decimals as the step needs, and exponents once that gets silly
+    static std::string _formatTickLabel(double value, double step)
+    {
+        char text[32];
+        int decimals = std::max(0, -static_cast<int>(std::floor(std::log10(step) + 1e-9)));
+        if (decimals > 5 || std::abs(value) >= 1e6) {
+            std::snprintf(text, sizeof(text), "%.3g", value);
+        } else {
+            std::snprintf(text, sizeof(text), "%.*f", decimals, value);
+        }
+        return text;
+    }
 
-        VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-        inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-        std::vector<VkDynamicState> dynamicStates = {
-            VK_DYNAMIC_STATE_VIEWPORT,
-            VK_DYNAMIC_STATE_SCISSOR
-        };
+    // Tick marks and labels along both axes, as glyph instances anchored to the ticks in plot coordinates so
+    // panning and zooming only move them in the vertex shader. A view's instances are only rewritten when its
+    // set of ticks changes, and then every label that was seen before comes laid out from the atlas' cache.
+    void _updateTextLabels()
+    {
+        const std::array<float, 4>& solidUvRect = _glyphAtlas.getSolidUvRect();
+        const float color[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        for (uint32_t viewIndex = 0; viewIndex < _views.size(); viewIndex++) {
+            PlotView& view = _views[viewIndex];
+            AxisTicks ticks = _computeAxisTicks(view);
+            if (view.builtTicks == ticks) {
+                continue;
+            }
+            view.builtTicks = ticks;
+            size_t layoutCount = _glyphAtlas.getLayoutCount();
+
+            GpuGlyphInstance* pInstances = _pGlyphInstances + viewIndex * _maxGlyphInstances;
+            uint32_t instanceCount = 0;
+            // Only the anchor component across the tick's axis is kept on screen, the one along it follows the view
+            auto addQuad = [&](uint32_t axis, float anchorX, float anchorY, float offsetX, float offsetY, float width, float height, const float* pUvRect) {
+                if (instanceCount == _maxGlyphInstances) {
+                    return;
+                }
+                GpuGlyphInstance& instance = pInstances[instanceCount++];
+                instance = GpuGlyphInstance{};
+                instance.anchor[0] = anchorX;
+                instance.anchor[1] = anchorY;
+                instance.offset[0] = offsetX;
+                instance.offset[1] = offsetY;
+                instance.size[0] = width;
+                instance.size[1] = height;
+                instance.clampMask[1 - axis] = 1.0f;
+                std::copy(pUvRect, pUvRect + 4, instance.uvRect);
+                std::copy(color, color + 4, instance.color);
+            };
+            auto addLabel = [&](uint32_t axis, float anchorX, float anchorY, float offsetX, float offsetY, const TextLayout& layout) {
+                for (const LaidOutGlyph& glyph : layout.glyphs) {
+                    addQuad(axis, anchorX, anchorY, offsetX + glyph.offset[0], offsetY + glyph.offset[1], glyph.size[0], glyph.size[1], glyph.uvRect);
+                }
+            };
 
-        VkPipelineDynamicStateCreateInfo dynamicState{};
-        dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-        dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
-        dynamicState.pDynamicStates = dynamicStates.data();
+            // The x axis labels go under their ticks, the y axis ones to the left of theirs. 0 is only labelled once.
+            for (int64_t index = ticks.first[0]; index <= ticks.last[0]; index++) {
+                float x = static_cast<float>(index * ticks.step[0]);
+                const TextLayout& layout = _glyphAtlas.layout(_formatTickLabel(index * ticks.step[0], ticks.step[0]));
+                addQuad(0, x, 0.0f, -1.0f, -_tickMarkLength / 2, 2.0f, _tickMarkLength, solidUvRect.data());
+                addLabel(0, x, 0.0f, -layout.width / 2, -_tickMarkLength - layout.height, layout);
+            }
+            for (int64_t index = ticks.first[1]; index <= ticks.last[1]; index++) {
+                float y = static_cast<float>(index * ticks.step[1]);
+                addQuad(1, 0.0f, y, -_tickMarkLength / 2, -1.0f, _tickMarkLength, 2.0f, solidUvRect.data());
+                if (index != 0) {
+                    const TextLayout& layout = _glyphAtlas.layout(_formatTickLabel(index * ticks.step[1], ticks.step[1]));
+                    addLabel(1, 0.0f, y, -_tickMarkLength - layout.width, -layout.height / 2, layout);
+                }
+            }
+            view.glyphInstanceCount = instanceCount;
+            _frameStats.labelRebuilds++;
+            _frameStats.labelsLaidOut += static_cast<uint32_t>(_glyphAtlas.getLayoutCount() - layoutCount);
+        }
+    }
+
+
+    GpuPlotTile* _getGpuTile(PlotVertexFormat format, uint32_t slot)
+    {
+        return _pTileData + static_cast<uint32_t>(format) * _tileSlotsPerPool + slot;
+    }
+
+
+    // Evicted tiles can be kept on the host, tiles whose format or function changed are stale and just dropped
+    void _releaseTile(std::map<PlotTileKey, ResidentPlotTile>::iterator it, bool keepOnHost = false)
+    {
+        if (keepOnHost) {
+            _cacheTileOnHost(it->first, it->second);
+            _frameStats.tilesEvicted++;
+        }
+        _freeTileSlot(it->second.format, it->second.slot);
+        _residentTiles.erase(it);
+    }
 
-        VkPipelineViewportStateCreateInfo viewportState{};
-        viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        viewportState.viewportCount = 1;
-        viewportState.scissorCount = 1;
 
-        VkPipelineRasterizationStateCreateInfo rasterizer{};
-        rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        rasterizer.depthClampEnable = VK_FALSE;
-        rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-        rasterizer.lineWidth = 1.0f;
-        rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-        rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-        rasterizer.depthBiasEnable = VK_FALSE;
-        rasterizer.depthBiasConstantFactor = 0.0f;
-        rasterizer.depthBiasClamp = 0.0f;
-        rasterizer.depthBiasSlopeFactor = 0.0f;
+    // The chunk stays allocated, it's only given back under memory pressure by _shrinkTilePool
+    void _freeTileSlot(PlotVertexFormat format, uint32_t slot)
+    {
+        PlotTilePool& pool = _tilePools[static_cast<size_t>(format)];
+        _getGpuTile(format, slot)->resident = 0;
+        pool.chunks[slot / _tilesPerChunk].usedSlotCount--;
+        (slot < _maxResidentTiles ? pool.freeSlots : _freeReservedTileSlots).insert(slot);
+    }
 
-        VkPipelineMultisampleStateCreateInfo multisampling{};
-        multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        multisampling.sampleShadingEnable = VK_FALSE;
-        multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-        multisampling.minSampleShading = 1.0f;
-        multisampling.pSampleMask = nullptr;
-        multisampling.alphaToCoverageEnable = VK_FALSE;
-        multisampling.alphaToOneEnable = VK_FALSE;
 
-        VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-        colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-        colorBlendAttachment.blendEnable = VK_FALSE;
-        colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-        colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-        colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-        colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-        colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-        colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    // Writes the evaluated columns in _tileColumns into the tile's staging slot in the given vertex format
+    void _encodeTile(PlotVertexFormat format, uint32_t slot, GpuPlotTile* pGpuTile)
+    {
+        const float* pX = _tileColumns.data();
+        const size_t stride = sizeof(PackedFunctionVertex) / sizeof(uint16_t);
+        PackedFunctionVertex* pPackedVertices = reinterpret_cast<PackedFunctionVertex*>(_getStagingVertices(format, slot));
+        FunctionVertex* pVertices = reinterpret_cast<FunctionVertex*>(_getStagingVertices(format, slot));
+        TileBounds& dequantisation = pGpuTile->dequantisation;
+        dequantisation = TileBounds{};
+
+        float minValue, maxValue;
+        if (format == PlotVertexFormat::Packed16) {
+            findMinMax(pX, _tileSampleCount, &minValue, &maxValue);
+            quantizeToUnorm16(pX, _tileSampleCount, minValue, maxValue, &pPackedVertices->x, stride);
+            dequantisation.xOffset = minValue;
+            dequantisation.xScale = maxValue - minValue;
+        }
+        for (uint32_t term = 0; term < PlotFunction::maxTerms; term++) {
+            const float* pColumn = pX + (term + 1) * _tileSampleCount;
+            findMinMax(pColumn, _tileSampleCount, &minValue, &maxValue);
+            pGpuTile->basisMin[term] = minValue;
+            pGpuTile->basisMax[term] = maxValue;
+            if (format == PlotVertexFormat::Packed16) {
+                quantizeToUnorm16(pColumn, _tileSampleCount, minValue, maxValue, &pPackedVertices->basis[term], stride);
+                dequantisation.basisOffset[term] = minValue;
+                dequantisation.basisScale[term] = maxValue - minValue;
+            }
+        }
+        if (format == PlotVertexFormat::Float32) {
+            for (uint32_t i = 0; i < _tileSampleCount; i++) {
+                pVertices[i].x = pX[i];
+                for (uint32_t term = 0; term < PlotFunction::maxTerms; term++) {
+                    pVertices[i].basis[term] = pX[(term + 1) * _tileSampleCount + i];
+                }
+            }
+        }
 
-        VkPipelineColorBlendStateCreateInfo colorBlending{};
-        colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        colorBlending.logicOpEnable = VK_FALSE;
-        colorBlending.logicOp = VK_LOGIC_OP_COPY;
-        colorBlending.attachmentCount = 1;
-        colorBlending.pAttachments = &colorBlendAttachment;
-        colorBlending.blendConstants[0] = 0.0f;
-        colorBlending.blendConstants[1] = 0.0f;
-        colorBlending.blendConstants[2] = 0.0f;
-        colorBlending.blendConstants[3] = 0.0f;
+        _queueTileUpload(format, slot);
+    }
 
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = 0;
-        pipelineLayoutInfo.pSetLayouts = nullptr;
-        pipelineLayoutInfo.pushConstantRangeCount = 0;
-        pipelineLayoutInfo.pPushConstantRanges = nullptr;
-        if (vkCreatePipelineLayout(_device, &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create pipeline layout.\n");
+
+    // Room has already been made by _evictTiles, so this only fails once the visible tiles alone fill the pool
+    std::optional<uint32_t> _acquireTileSlot(PlotVertexFormat format)
+    {
+        PlotTilePool& pool = _tilePools[static_cast<size_t>(format)];
+        if (pool.freeSlots.empty()) {
+            return std::nullopt;
         }
+        uint32_t slot = *pool.freeSlots.begin();
+        pool.freeSlots.erase(pool.freeSlots.begin());
+        _useTileSlot(pool, slot);
+        return slot;
+    }
 
-        VkGraphicsPipelineCreateInfo pipelineInfo{};
-        pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        pipelineInfo.stageCount = 2;
-        pipelineInfo.pStages = shaderStages;
-        pipelineInfo.pVertexInputState = &vertexInputInfo;
-        pipelineInfo.pInputAssemblyState = &inputAssembly;
-        pipelineInfo.pViewportState = &viewportState;
-        pipelineInfo.pRasterizationState = &rasterizer;
-        pipelineInfo.pMultisampleState = &multisampling;
-        pipelineInfo.pDepthStencilState = nullptr;
-        pipelineInfo.pColorBlendState = &colorBlending;
-        pipelineInfo.pDynamicState = &dynamicState;
-        pipelineInfo.layout = _pipelineLayout;
-        pipelineInfo.renderPass = _renderPass;
-        pipelineInfo.subpass = 0;
-        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-        pipelineInfo.basePipelineIndex = -1;
 
-        if (vkCreateGraphicsPipelines(_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_graphicsPipeline) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create graphics pipeline\n");
+    void _useTileSlot(PlotTilePool& pool, uint32_t slot)
+    {
+        PlotTileChunk& chunk = pool.chunks[slot / _tilesPerChunk];
+        if (chunk.vertexBuffer == VK_NULL_HANDLE) {
+            _allocateTileChunk(pool, chunk);
         }
+        chunk.usedSlotCount++;
+    }
 
-        vkDestroyShaderModule(_device, vertShaderModule, nullptr);
-        vkDestroyShaderModule(_device, fragShaderModule, nullptr);
-        std::cout << "Successfully created graphics pipeline!\n";
+
+    // Evicts up to count of the least recently drawn tiles of the format to the host cache. Tiles marked this frame
+    // or visible in any view are never picked, so the visible tiles can take the pool over the residency limit.
+    void _evictTiles(PlotVertexFormat format, uint32_t count)
+    {
+        std::vector<std::map<PlotTileKey, ResidentPlotTile>::iterator> candidates;
+        for (auto it = _residentTiles.begin(); it != _residentTiles.end(); it++) {
+            if (it->second.format == format && it->second.lastUsedFrame != _frameNumber && !_isTileVisible(it->first)) {
+                candidates.push_back(it);
+            }
+        }
+        count = std::min(count, static_cast<uint32_t>(candidates.size()));
+        std::nth_element(candidates.begin(), candidates.begin() + count, candidates.end(), [](const auto& a, const auto& b) {
+            return a->second.lastUsedFrame < b->second.lastUsedFrame;
+        });
+        for (uint32_t i = 0; i < count; i++) {
+            _releaseTile(candidates[i], true);
+        }
     }
 
 
-    static std::vector<char> _readFile(const std::string& fileName)
+    // lastUsedFrame only moves when the visible tiles get worked out again, so check against the last view state too
+    bool _isTileVisible(const PlotTileKey& key) const
     {
-        std::ifstream file(fileName, std::ios::ate | std::ios::binary);
-        if (!file.is_open()) {
-            throw std::runtime_error("Failed to open file " + fileName);
+        if (!_lastTileViewState.has_value()) {
+            return false;
+        }
+        for (const auto& [level, firstIndex, lastIndex] : _lastTileViewState->viewTiles) {
+            if (key.level == level && key.index >= firstIndex && key.index <= lastIndex) {
+                return true;
+            }
         }
+        return false;
+    }
 
-        size_t fileSize = (size_t)file.tellg();
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        file.close();
-        return buffer;
+
+    // Tiles are evicted least recently drawn first, so the cache drops the ones that went into it longest ago when full
+    void _cacheTileOnHost(const PlotTileKey& key, const ResidentPlotTile& tile)
+    {
+        auto indexIt = _hostTileCacheIndex.find(key);
+        if (indexIt != _hostTileCacheIndex.end()) {
+            _hostTileCache.splice(_hostTileCache.begin(), _hostTileCache, indexIt->second);
+        } else {
+            if (_hostTileCache.size() == _maxHostCachedTiles) {
+                _hostTileCacheIndex.erase(_hostTileCache.back().first);
+                _hostTileCache.pop_back();
+            }
+            _hostTileCache.emplace_front(key, HostCachedPlotTile{});
+            _hostTileCacheIndex[key] = _hostTileCache.begin();
+        }
+        size_t tileSize = _tilePools[static_cast<size_t>(tile.format)].vertexSize * _tileSampleCount;
+        const uint8_t* pVertices = _getStagingVertices(tile.format, tile.slot);
+        HostCachedPlotTile& cachedTile = _hostTileCache.front().second;
+        cachedTile.format = tile.format;
+        cachedTile.structureRevision = tile.structureRevision;
+        cachedTile.gpuTile = *_getGpuTile(tile.format, tile.slot);
+        cachedTile.vertices.assign(pVertices, pVertices + tileSize);
     }
 
 
-    VkShaderModule _createShaderModule(const std::vector<char>& code)
+    // Puts a host cached tile back into its new slot through the staging buffer, if there's an up to date one
+    bool _restoreTile(const PlotTileKey& key, const ResidentPlotTile& tile, uint32_t functionIndex)
     {
-        VkShaderModuleCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
-        VkShaderModule shaderModule;
-        VkResult shaderModuleCreateResult= vkCreateShaderModule(_device, &createInfo, nullptr, &shaderModule);
-        if (shaderModuleCreateResult != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create shader module.");
+        auto indexIt = _hostTileCacheIndex.find(key);
+        if (indexIt == _hostTileCacheIndex.end()) {
+            return false;
         }
-        return shaderModule;
+        HostCachedPlotTile cachedTile = std::move(indexIt->second->second);
+        _hostTileCache.erase(indexIt->second);
+        _hostTileCacheIndex.erase(indexIt);
+        if (cachedTile.format != tile.format || cachedTile.structureRevision != tile.structureRevision) {
+            return false;
+        }
+
+        std::memcpy(_getStagingVertices(tile.format, tile.slot), cachedTile.vertices.data(), cachedTile.vertices.size());
+        _queueTileUpload(tile.format, tile.slot);
+
+        GpuPlotTile* pGpuTile = _getGpuTile(tile.format, tile.slot);
+        *pGpuTile = cachedTile.gpuTile;
+        pGpuTile->functionIndex = functionIndex;
+        pGpuTile->slot = tile.slot;
+        pGpuTile->resident = 1;
+        _frameStats.tilesRestored++;
+        return true;
     }
 
 
-    void _createRenderPass()
+    // Polled once a frame. The tiles get whatever is left of the device local budget once everything else (the rest
+    // of this process and anyone else on the device) is accounted for. Going over it sends the least recently drawn
+    // tiles (and so the levels nobody is looking at) to the host cache, and frees the tile chunks that empties out.
+    void _pollMemoryBudget()
     {
-        VkAttachmentDescription colorAttachment{};
-        colorAttachment.format = _swapchainImageFormat;
-        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        if (!_memoryBudgetSupported) {
+            return;
+        }
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+        budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+        memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        memoryProperties.pNext = &budgetProperties;
+        vkGetPhysicalDeviceMemoryProperties2(_physicalDevice, &memoryProperties);
+
+        _deviceLocalBudget = 0;
+        _deviceLocalUsage = 0;
+        for (uint32_t heap = 0; heap < memoryProperties.memoryProperties.memoryHeapCount; heap++) {
+            if ((memoryProperties.memoryProperties.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) == 0 || budgetProperties.heapBudget[heap] == 0) {
+                continue;
+            }
+            _deviceLocalBudget += budgetProperties.heapBudget[heap];
+            _deviceLocalUsage += budgetProperties.heapUsage[heap];
+        }
 
-        VkAttachmentReference colorAttachmentRef{};
-        colorAttachmentRef.attachment = 0;
-        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-        
-        VkSubpassDescription subpass{};
-        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpass.colorAttachmentCount = 1;
-        subpass.pColorAttachments = &colorAttachmentRef;
+        // heapUsage includes the tile chunks themselves, so take them back out to get what they're competing with
+        VkDeviceSize otherUsage = _deviceLocalUsage - std::min(_deviceLocalUsage, _tileChunkMemory);
+        VkDeviceSize usableBudget = static_cast<VkDeviceSize>(static_cast<double>(_deviceLocalBudget) * _maxMemoryBudgetUse);
+        _tileMemoryBudget = usableBudget - std::min(usableBudget, otherUsage);
 
-        VkRenderPassCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        createInfo.attachmentCount = 1;
-        createInfo.pAttachments = &colorAttachment;
-        createInfo.subpassCount = 1;
-        createInfo.pSubpasses = &subpass;
+        // Both formats can be in use, so a slot of each counts against the budget
+        VkDeviceSize slotBytes = 0;
+        for (const PlotTilePool& pool : _tilePools) {
+            slotBytes += pool.vertexSize * _tileSampleCount;
+        }
+        _tileResidencyLimit = static_cast<uint32_t>(std::clamp<VkDeviceSize>(_tileMemoryBudget / slotBytes, _minTileResidencyLimit, _maxResidentTiles));
+        _enforceTileResidencyLimit();
+    }
 
-        if (vkCreateRenderPass(_device, &createInfo, nullptr, &_renderPass) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create render pass");
+
+    void _enforceTileResidencyLimit()
+    {
+        for (uint32_t format = 0; format < static_cast<uint32_t>(PlotVertexFormat::Count); format++) {
+            uint32_t usedSlots = _maxResidentTiles - static_cast<uint32_t>(_tilePools[format].freeSlots.size());
+            if (usedSlots > _tileResidencyLimit) {
+                _evictTiles(static_cast<PlotVertexFormat>(format), usedSlots - _tileResidencyLimit);
+            }
+        }
+        if (_memoryBudgetSupported && _tileChunkMemory > _tileMemoryBudget) {
+            for (PlotTilePool& pool : _tilePools) {
+                _shrinkTilePool(pool);
+            }
         }
-        std::cout << "successfully created Render pass!\n";
     }
 
 
-    void _createFrameBuffers()
+    // Moves the resident tiles down into the lowest free slots, through the staging buffers, so the chunks at the end
+    // of the pool empty out and can be freed. Tiles reserved for the data and implicit plots stay where they are.
+    void _shrinkTilePool(PlotTilePool& pool)
     {
-        _swapchainFrameBuffers.resize(_swapchainImageViews.size());
-        for (size_t i = 0; i < _swapchainFrameBuffers.size(); i++) {
-            VkImageView attachments[] = {
-                _swapchainImageViews[i]
-            };
-            VkFramebufferCreateInfo createInfo{};
-            createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-            createInfo.renderPass = _renderPass;
-            createInfo.attachmentCount = 1;
-            createInfo.pAttachments = attachments;
-            createInfo.width = _swapchainExtent.width;
-            createInfo.height = _swapchainExtent.height;
-            createInfo.layers = 1;
-            if (vkCreateFramebuffer(_device, &createInfo, nullptr, &_swapchainFrameBuffers[i]) != VK_SUCCESS) {
-               throw std::runtime_error("Failed to create framebuffer");
+        const PlotVertexFormat format = static_cast<PlotVertexFormat>(&pool - _tilePools);
+        const uint32_t usedSlots = _maxResidentTiles - static_cast<uint32_t>(pool.freeSlots.size());
+        const uint32_t keptChunkCount = (usedSlots + _tilesPerChunk - 1) / _tilesPerChunk;
+        for (auto& [key, tile] : _residentTiles) {
+            if (tile.format != format || tile.slot / _tilesPerChunk < keptChunkCount) {
+                continue;
+            }
+            uint32_t slot = *pool.freeSlots.begin();
+            if (slot > tile.slot) {
+                continue;
+            }
+            pool.freeSlots.erase(pool.freeSlots.begin());
+            _useTileSlot(pool, slot);
+            std::memcpy(_getStagingVertices(format, slot), _getStagingVertices(format, tile.slot), pool.vertexSize * _tileSampleCount);
+            _queueTileUpload(format, slot);
+            GpuPlotTile* pGpuTile = _getGpuTile(format, slot);
+            *pGpuTile = *_getGpuTile(format, tile.slot);
+            pGpuTile->slot = slot;
+            _freeTileSlot(format, tile.slot);
+            tile.slot = slot;
+        }
+        for (PlotTileChunk& chunk : pool.chunks) {
+            if (chunk.usedSlotCount == 0 && chunk.vertexBuffer != VK_NULL_HANDLE) {
+                _freeTileChunk(pool, chunk);
+                _frameStats.tileChunksFreed++;
             }
         }
-        std::cout << "Successfully created frame buffers!\n";
     }
 
 
-    void _createCommandPool()
+    void _drawFrame()
     {
-        QueueFamilyIndices indices = _findQueueFamilies(_physicalDevice);
-        VkCommandPoolCreateInfo createInfo{};
-        createInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        createInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        createInfo.queueFamilyIndex = indices.graphicsFamily.value();
-        if (vkCreateCommandPool(_device, &createInfo, nullptr, &_commandPool) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create command pool\n");
+        vkWaitForFences(_device, 1, &_inFlightFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+        vkResetFences(_device, 1, &_inFlightFence);
+        // An async queue's submit can still be running if the graphics one didn't wait on it
+        for (const AsyncQueue& asyncQueue : _asyncQueues) {
+            if (asyncQueue.queue == VK_NULL_HANDLE) {
+                continue;
+            }
+            VkSemaphoreWaitInfo waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &asyncQueue.timelineSemaphore;
+            waitInfo.pValues = &asyncQueue.timelineValue;
+            vkWaitSemaphores(_device, &waitInfo, std::numeric_limits<uint64_t>::max());
+        }
+        _readPlotTimestamps();
+        _updateDomainExpression();
+        _pollMemoryBudget();
+
+        for (PlotView& view : _views) {
+            vkAcquireNextImageKHR(_device, view.swapchain, std::numeric_limits<uint64_t>::max(), view.imageAvailableSemaphore, VK_NULL_HANDLE, &view.imageIndex);
+        }
+
+        std::chrono::steady_clock::time_point updateStart = std::chrono::steady_clock::now();
+        _frameNumber++;
+        _updatePlotTiles();
+        _updateDataPlots();
+        _updateImplicitPlots();
+        _updateTextLabels();
+        for (size_t i = 0; i < _plotFunctions.size(); i++) {
+            _plotFunctions[i]->fillGpuData(&_pFunctionData[i]);
         }
+        RenderGraph graph;
+        _recordFrame(graph);
+        _frameStats.updateTime += std::chrono::steady_clock::now() - updateStart;
+
+        // The async queues go first, in RenderGraphQueue order, each waiting on the earlier ones the graph says it
+        // depends on. The fence only covers the graphics submit, so the next frame waits on their semaphores itself.
+        for (size_t i = 0; i < std::size(_asyncQueues); i++) {
+            RenderGraphQueue queue = static_cast<RenderGraphQueue>(i);
+            if (!graph.hasPasses(queue)) {
+                continue;
+            }
+            std::vector<VkSemaphore> waitSemaphores;
+            std::vector<VkPipelineStageFlags> waitStages;
+            std::vector<uint64_t> waitValues;
+            for (size_t j = 0; j < i; j++) {
+                VkPipelineStageFlags stages = graph.getWaitStages(queue, static_cast<RenderGraphQueue>(j));
+                if (stages != 0) {
+                    waitSemaphores.push_back(_asyncQueues[j].timelineSemaphore);
+                    waitStages.push_back(stages);
+                    waitValues.push_back(_asyncQueues[j].timelineValue);
+                }
+            }
+            AsyncQueue& asyncQueue = _asyncQueues[i];
+            asyncQueue.timelineValue++;
+            VkTimelineSemaphoreSubmitInfo timelineInfo{};
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+            timelineInfo.pWaitSemaphoreValues = waitValues.data();
+            timelineInfo.signalSemaphoreValueCount = 1;
+            timelineInfo.pSignalSemaphoreValues = &asyncQueue.timelineValue;
+            VkSubmitInfo asyncSubmitInfo{};
+            asyncSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            asyncSubmitInfo.pNext = &timelineInfo;
+            asyncSubmitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+            asyncSubmitInfo.pWaitSemaphores = waitSemaphores.data();
+            asyncSubmitInfo.pWaitDstStageMask = waitStages.data();
+            asyncSubmitInfo.commandBufferCount = 1;
+            asyncSubmitInfo.pCommandBuffers = &asyncQueue.commandBuffer;
+            asyncSubmitInfo.signalSemaphoreCount = 1;
+            asyncSubmitInfo.pSignalSemaphores = &asyncQueue.timelineSemaphore;
+            if (vkQueueSubmit(asyncQueue.queue, 1, &asyncSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+                throw std::runtime_error(std::string("Failed to submit ") + getRenderGraphQueueName(queue) + " command buffer");
+            }
+        }
+
+        // Every view goes in the one submit and the one present
+        std::vector<VkSemaphore> waitSemaphores;
+        std::vector<VkPipelineStageFlags> waitStages;
+        std::vector<uint64_t> waitValues; // Only the timeline semaphores' are used, the binary ones are ignored
+        std::vector<VkSemaphore> signalSemaphores;
+        std::vector<VkSwapchainKHR> swapchains;
+        std::vector<uint32_t> imageIndices;
+        for (const PlotView& view : _views) {
+            waitSemaphores.push_back(view.imageAvailableSemaphore);
+            waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+            waitValues.push_back(0);
+            signalSemaphores.push_back(view.renderFinishedSemaphore);
+            swapchains.push_back(view.swapchain);
+            imageIndices.push_back(view.imageIndex);
+        }
+        for (size_t i = 0; i < std::size(_asyncQueues); i++) {
+            VkPipelineStageFlags stages = graph.getWaitStages(RenderGraphQueue::Graphics, static_cast<RenderGraphQueue>(i));
+            if (stages != 0) {
+                waitSemaphores.push_back(_asyncQueues[i].timelineSemaphore);
+                waitStages.push_back(stages);
+                waitValues.push_back(_asyncQueues[i].timelineValue);
+            }
+        }
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+        timelineInfo.pWaitSemaphoreValues = waitValues.data();
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+        submitInfo.pWaitSemaphores = waitSemaphores.data();
+        submitInfo.pWaitDstStageMask = waitStages.data();
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &_commandBuffer;
+        submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+        submitInfo.pSignalSemaphores = signalSemaphores.data();
+        if (vkQueueSubmit(_graphicsQueue, 1, &submitInfo, _inFlightFence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit draw command buffer");
+        }
+
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+        presentInfo.pWaitSemaphores = signalSemaphores.data();
+        presentInfo.swapchainCount = static_cast<uint32_t>(swapchains.size());
+        presentInfo.pSwapchains = swapchains.data();
+        presentInfo.pImageIndices = imageIndices.data();
+        vkQueuePresentKHR(_presentQueue, &presentInfo);
+
+        _frameStats.frames++;
+        _printFrameStats();
     }
 
 
-    void _createCommandBuffer()
+    // The previous frame's fence has been waited on, so its timestamps are ready
+    // Only the low timestampValidBits of each timestamp count, so the difference is masked to those to survive a wrap
+    void _readPlotTimestamps()
     {
-        VkCommandBufferAllocateInfo allocateInfo{};
-        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocateInfo.commandPool = _commandPool;
-        allocateInfo.commandBufferCount = 1;
-        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        if (vkAllocateCommandBuffers(_device, &allocateInfo, &_commandBuffer) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to allocate command buffers.");
+        if (!_timestampsWritten) {
+            return;
+        }
+        uint64_t timestamps[2] = {0, 0};
+        if (vkGetQueryPoolResults(_device, _timestampQueryPool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+            _lastPlotGpuMicroseconds = static_cast<double>((timestamps[1] - timestamps[0]) & _timestampMask) * _timestampPeriod / 1000.0;
+            _frameStats.plotGpuMicroseconds += _lastPlotGpuMicroseconds;
         }
     }
 
 
-    void _recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+    void _printFrameStats()
     {
-        VkCommandBufferBeginInfo beginInfo{};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = 0;
-        beginInfo.pInheritanceInfo = nullptr;
-        if (vkBeginCommandBuffer(_commandBuffer, &beginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to begin command buffer recording\n");
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now - _frameStats.start < std::chrono::seconds(1)) {
+            return;
         }
-        
-        VkRenderPassBeginInfo renderPassInfo{};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = _renderPass;
-        renderPassInfo.framebuffer = _swapchainFrameBuffers[imageIndex];
-        renderPassInfo.renderArea.offset = {0, 0};
-        renderPassInfo.renderArea.extent = _swapchainExtent;
-        VkClearValue clearColor = {{{1.0f, 0.0f, 0.0f, 1.0f}}}; // Red ClearColor;
-        renderPassInfo.clearValueCount = 1;
-        renderPassInfo.pClearValues = &clearColor;
-        
-        vkCmdBeginRenderPass(_commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _graphicsPipeline);
 
-        VkViewport viewport{};
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = static_cast<float>(_swapchainExtent.width);
-        viewport.height = static_cast<float>(_swapchainExtent.height);
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(_commandBuffer, 0, 1, &viewport);
-        
-        VkRect2D scissor{};
-        scissor.offset = {0, 0};
-        vkCmdSetScissor(_commandBuffer, 0, 1, &scissor);
-        vkCmdDraw(_commandBuffer, 3, 1, 0, 0);
-        vkCmdEndRenderPass(_commandBuffer);
-        if (vkEndCommandBuffer(_commandBuffer) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to execute command buffer.\n");
+        VkDeviceSize residentBytes[static_cast<size_t>(PlotVertexFormat::Count)] = {};
+        uint32_t residentVertices[static_cast<size_t>(PlotVertexFormat::Count)] = {};
+        for (const auto& [key, tile] : _residentTiles) {
+            residentBytes[static_cast<size_t>(tile.format)] += _tilePools[static_cast<size_t>(tile.format)].vertexSize * _tileSampleCount;
+            residentVertices[static_cast<size_t>(tile.format)] += _tileSampleCount;
+        }
+
+        double updateMicroseconds = std::chrono::duration<double, std::micro>(_frameStats.updateTime).count() / _frameStats.frames;
+        std::cout << "Frames: " << _frameStats.frames
+                  << " | Plot functions: " << _plotFunctions.size()
+                  << " | Tiles evaluated: " << _frameStats.tilesEvaluated
+                  << " | Resident tiles: " << _residentTiles.size()
+                  << " | CPU update per frame: " << updateMicroseconds << "us"
+                  << " | Plot GPU time per frame: " << (_timestampsSupported ? std::to_string(_frameStats.plotGpuMicroseconds / _frameStats.frames) + "us" : std::string("n/a"))
+                  << " | Float32 vertices: " << residentVertices[0] << " (" << residentBytes[0] / 1024 << " KiB)"
+                  << " | Packed16 vertices: " << residentVertices[1] << " (" << residentBytes[1] / 1024 << " KiB)"
+                  << " | Data vertices streamed: " << _frameStats.dataVerticesStreamed
+                  << " | Contour cells: " << _frameStats.contourCellsEvaluated
+                  << " | Contour vertices dropped: " << _frameStats.contourVerticesDropped
+                  << " | Label rebuilds: " << _frameStats.labelRebuilds
+                  << " | Labels laid out: " << _frameStats.labelsLaidOut
+                  << " | Glyph instances: " << std::accumulate(_views.begin(), _views.end(), 0u, [](uint32_t sum, const PlotView& view) { return sum + view.glyphInstanceCount; })
+                  << " | Barriers per frame: " << _frameStats.barriers / _frameStats.frames
+                  << " | Transient buffers: " << _frameStats.transientMemoryBytes / 1024 << " KiB (" << _frameStats.transientBufferBytes / 1024 << " KiB unaliased)";
+        if (_memoryBudgetSupported) {
+            std::cout << " | VRAM: " << _deviceLocalUsage / (1024 * 1024) << " / " << _deviceLocalBudget / (1024 * 1024) << " MiB";
+        } else {
+            std::cout << " | VRAM: no budget extension";
         }
+        std::cout << " | Tile residency limit: " << _tileResidencyLimit
+                  << " | Tiles evicted: " << _frameStats.tilesEvicted
+                  << " | Tile chunks: " << _tileChunkMemory / (1024 * 1024) << " MiB"
+                  << " | Tile chunks freed: " << _frameStats.tileChunksFreed
+                  << " | Tiles restored: " << _frameStats.tilesRestored
+                  << " | Tiles skipped: " << _frameStats.tilesSkipped
+                  << " | Host cached tiles: " << _hostTileCache.size() << "\n";
+        _frameStats = {};
+        _frameStats.start = now;
     }
 
 
@@ -837,23 +5412,196 @@ private:
     bool _isRunning = true;
     const uint32_t _windowWidth = 500;
     const uint32_t _windowHeight = 500;
-    SDL_Window* _pWindow = nullptr;
     VkInstance _instance = VK_NULL_HANDLE;
     VkDebugUtilsMessengerEXT _debugMessenger = VK_NULL_HANDLE;
-    VkSurfaceKHR _surface = VK_NULL_HANDLE;
     VkPhysicalDevice _physicalDevice = VK_NULL_HANDLE;
     VkDevice _device = VK_NULL_HANDLE;
     VkQueue _graphicsQueue = VK_NULL_HANDLE;
     VkQueue _presentQueue = VK_NULL_HANDLE;
-    VkSwapchainKHR _swapchain = VK_NULL_HANDLE;
-    std::vector<VkImage> _swapchainImages;
-    VkFormat _swapchainImageFormat;
-    VkExtent2D _swapchainExtent;
+    VkSurfaceFormatKHR _surfaceFormat; // Picked for the first view, the render pass and every other view use it too
     VkRenderPass _renderPass;
     VkPipelineLayout _pipelineLayout;
-    VkPipeline _graphicsPipeline;
+    VkPipeline _graphicsPipelines[static_cast<size_t>(PlotVertexFormat::Count)];
     VkCommandPool _commandPool;
     VkCommandBuffer _commandBuffer;
+    VkFence _inFlightFence;
+    uint32_t _graphicsQueueFamily = 0;
+    // The queues besides the graphics one that the frame's render graph can put passes on, indexed by
+    // RenderGraphQueue::Transfer and Compute. Their queue stays null when the device has no such family.
+    struct AsyncQueue
+    {
+        uint32_t family = 0;
+        VkQueue queue = VK_NULL_HANDLE;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkSemaphore timelineSemaphore = VK_NULL_HANDLE; // Counts its submits, the later queues wait on it
+        uint64_t timelineValue = 0;
+    };
+    AsyncQueue _asyncQueues[2]; // Transfer and compute, in RenderGraphQueue order. No queue if the GPU hasn't got the family.
+    RenderGraphTransientMemory _transientMemory;
+    PlotTilePool _tilePools[static_cast<size_t>(PlotVertexFormat::Count)];
+    VkQueryPool _timestampQueryPool = VK_NULL_HANDLE;
+    float _timestampPeriod = 0.0f;
+    bool _timestampsSupported = false;
+    uint64_t _timestampMask = 0;
+    bool _timestampsWritten = false;
+    double _lastPlotGpuMicroseconds = 0.0;
+    uint32_t _formatBenchmarkFunctionCount = 0;
+    std::chrono::steady_clock::duration _tileEncodeTime{}; // Only _encodeTile's share of _updatePlotTiles, for the format benchmark
+    uint64_t _tileEncodeVertexCount = 0;
+
+    const uint32_t _tileSampleCount = 64;
+    const float _tilesAcrossView = 8.0f;
+    const uint32_t _maxPlotFunctions = 1024;
+    const uint32_t _maxReservedFunctions = 64; // Function data entries past _maxPlotFunctions, for data and implicit plots
+    // The level keeps a view _tilesAcrossView tiles wide at most, plus one for the tile it starts part way into
+    const uint32_t _maxVisibleTilesPerFunction = static_cast<uint32_t>(_tilesAcrossView) + 1;
+    const uint32_t _maxViews = 4;
+    // Per vertex format, enough for every function to be fully visible in every view at once, each at its own
+    // level, so a visible tile always gets a slot
+    const uint32_t _maxResidentTiles = _maxPlotFunctions * _maxVisibleTilesPerFunction * _maxViews;
+    const uint32_t _tilesPerChunk = 1024; // The granularity tile memory is allocated and freed at
+    // Float pool slots past the function tiles, for data and implicit plots. 32 data plots at 4K.
+    const uint32_t _maxReservedTiles = 4 * _tilesPerChunk;
+    const uint32_t _tileSlotsPerPool = _maxResidentTiles + _maxReservedTiles;
+    uint64_t _frameNumber = 0;
+    PlotFunction _quadratic;
+    std::deque<PlotFunction> _stressTestFunctions;
+    std::vector<const PlotFunction*> _plotFunctions;
+
+    struct TileViewState
+    {
+        std::vector<std::tuple<int32_t, int64_t, int64_t>> viewTiles; // Level, first and last index for each view
+        size_t functionCount;
+        uint64_t revisionSum;
+
+        bool operator==(const TileViewState& other) const = default;
+    };
+    std::optional<TileViewState> _lastTileViewState;
+
+    std::deque<PlotView> _views; // A deque so a view opened from another's key handler doesn't move the others
+
+    struct DataPlot
+    {
+        DataPlotSource source;
+        std::vector<uint32_t> slots; // Float32 pool slots, never seen by the LRU eviction
+        uint32_t functionIndex; // In the reserved region past _maxPlotFunctions, so stress test functions don't move it
+        std::optional<std::pair<float, float>> builtXRange;
+    };
+    std::vector<std::string> _dataFilePaths;
+    std::deque<DataPlot> _dataPlots;
+    std::vector<FunctionVertex> _dataVertices;
+
+    struct ImplicitPlot
+    {
+        std::string equation;
+        std::vector<ExpressionInstruction> program;
+        std::vector<uint32_t> slots; // Float32 pool slots, like a data plot's
+        uint32_t functionIndex;
+        std::optional<std::array<float, 4>> builtViewRange;
+    };
+    std::vector<std::string> _pendingImplicitEquations;
+    std::deque<ImplicitPlot> _implicitPlots;
+    ContourExtractor _contourExtractor;
+    const std::vector<std::string> _implicitEquations = {
+        "x^2 + y^2 = 1",
+        "y^2 = x^3 - x + 0.25",
+        "sin(3x) + cos(3y) = 0.5",
+        "x^4 + y^4 = 4x*y"
+    };
+    size_t _implicitEquationIndex = _implicitEquations.size() - 1;
+    uint32_t _reservedFunctionCount = 0;
+
+    VkDescriptorSetLayout _descriptorSetLayout;
+    VkDescriptorSetLayout _cullDescriptorSetLayout;
+    VkDescriptorPool _descriptorPool;
+    VkDescriptorSet _descriptorSet;
+    std::vector<VkDescriptorSet> _cullDescriptorSets; // One per view, for its draw buffers
+    VkPipelineLayout _cullPipelineLayout;
+    VkPipeline _cullPipeline;
+    bool _drawIndirectCountSupported = false;
+    VkBuffer _tileDataBuffer;
+    VkDeviceMemory _tileDataBufferMemory;
+    GpuPlotTile* _pTileData = nullptr;
+    VkBuffer _functionDataBuffer;
+    VkDeviceMemory _functionDataBufferMemory;
+    GpuPlotFunction* _pFunctionData = nullptr;
+    VkBuffer _indexBuffer;
+    VkDeviceMemory _indexBufferMemory;
+
+    const std::vector<std::string> _shaderFileNames = {
+        "shaders/vert.spv",
+        "shaders/frag.spv",
+        "shaders/cull.spv",
+        "shaders/fullscreen.spv",
+        "shaders/domainColoring.spv",
+        "shaders/textVert.spv",
+        "shaders/textFrag.spv"
+    };
+    std::map<std::string, std::vector<char>> _shaderCode;
+    std::map<std::string, VkShaderModule> _shaderModules;
+
+    VkPipeline _domainColoringPipeline;
+    VkPipeline _textPipeline;
+    GlyphAtlas _glyphAtlas;
+    VkImage _glyphAtlasImage;
+    VkDeviceMemory _glyphAtlasImageMemory;
+    VkImageView _glyphAtlasImageView;
+    VkSampler _glyphAtlasSampler;
+    VkBuffer _glyphInstanceBuffer;
+    VkDeviceMemory _glyphInstanceBufferMemory;
+    GpuGlyphInstance* _pGlyphInstances = nullptr;
+    const uint32_t _maxGlyphInstances = 4096; // Per view
+    const float _pixelsPerTick = 100.0f;
+    const float _tickMarkLength = 8.0f;
+    VkBuffer _expressionBuffer;
+    VkDeviceMemory _expressionBufferMemory;
+    GpuExpression* _pExpressionData = nullptr;
+    bool _domainColoringEnabled = false; // D turns it on
+    std::optional<std::string> _pendingDomainExpression;
+    size_t _domainExpressionIndex = 0;
+    const std::vector<std::string> _domainExpressions = {
+        "(z^2 - 1)(z - 2 - i)^2 / (z^2 + 2 + 2i)",
+        "z^3 - 1",
+        "sin(z) / z",
+        "exp(1 / z)",
+        "sqrt(z^2 + 1)"
+    };
+    std::map<PlotTileKey, ResidentPlotTile> _residentTiles;
+    std::set<uint32_t> _freeReservedTileSlots;
+    std::list<std::pair<PlotTileKey, HostCachedPlotTile>> _hostTileCache; // Most recently cached first
+    std::map<PlotTileKey, std::list<std::pair<PlotTileKey, HostCachedPlotTile>>::iterator> _hostTileCacheIndex;
+    const size_t _maxHostCachedTiles = 8192;
+    bool _memoryBudgetSupported = false;
+    VkDeviceSize _deviceLocalBudget = 0;
+    VkDeviceSize _deviceLocalUsage = 0;
+    const double _maxMemoryBudgetUse = 0.9; // Headroom for the driver and everything else on the device
+    VkDeviceSize _tileMemoryBudget = 0;
+    VkDeviceSize _tileChunkMemory = 0; // Device local, the staging buffers are host memory
+    const uint32_t _minTileResidencyLimit = 64;
+    uint32_t _tileResidencyLimit = _maxResidentTiles; // Per vertex format
+    std::vector<float> _tileColumns;
+
+    struct FrameStats
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint32_t frames = 0;
+        uint32_t tilesEvaluated = 0;
+        std::chrono::steady_clock::duration updateTime{};
+        double plotGpuMicroseconds = 0.0;
+        uint32_t dataVerticesStreamed = 0;
+        uint32_t contourCellsEvaluated = 0;
+        uint32_t contourVerticesDropped = 0;
+        uint32_t labelRebuilds = 0;
+        uint32_t labelsLaidOut = 0;
+        uint32_t barriers = 0;
+        VkDeviceSize transientBufferBytes = 0; // The last frame's, what its transient buffers would take without aliasing
+        VkDeviceSize transientMemoryBytes = 0; // And what they actually took
+        uint32_t tilesEvicted = 0;
+        uint32_t tileChunksFreed = 0;
+        uint32_t tilesRestored = 0;
+        uint32_t tilesSkipped = 0;
+    } _frameStats;
 
 
     const std::vector<const char*> _validationLayers = {
@@ -864,8 +5612,6 @@ private:
         "VK_KHR_portability_subset"
     };
 
-    std::vector<VkImageView> _swapchainImageViews;
-    std::vector<VkFramebuffer> _swapchainFrameBuffers;
     
 #ifdef NDEBUG
     const bool _enableValidationLayers = false;
@@ -875,10 +5621,66 @@ private:
 };
 
 
-int main()
+// Contouring throughput in grid cells per second for each thread count, with the speedup over one thread
+void runContourBenchmark()
+{
+    const std::vector<std::string> equations = {"x^2 + y^2 = 1", "sin(3x) + cos(3y) = 0.5"};
+    std::vector<uint32_t> threadCounts;
+    for (uint32_t threadCount = 1; threadCount < std::thread::hardware_concurrency(); threadCount *= 2) {
+        threadCounts.push_back(threadCount);
+    }
+    threadCounts.push_back(std::max(1u, std::thread::hardware_concurrency()));
+    for (const std::string& equation : equations) {
+        std::vector<ExpressionInstruction> program = ContourExtractor::compileEquation(equation);
+        for (uint32_t gridSize : {512u, 2048u}) {
+            ContourGrid grid = {-2.0f, 2.0f, -2.0f, 2.0f, gridSize, gridSize};
+            double singleThreadSeconds = 0.0;
+            for (uint32_t threadCount : threadCounts) {
+                ContourExtractor extractor(threadCount);
+                const uint32_t repeatCount = 5;
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                size_t polylineCount = 0;
+                for (uint32_t repeat = 0; repeat < repeatCount; repeat++) {
+                    polylineCount = extractor.extract(program, grid).size();
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeatCount;
+                if (threadCount == 1) {
+                    singleThreadSeconds = seconds;
+                }
+                std::cout << equation << " | " << gridSize << "x" << gridSize << " cells | " << threadCount << " threads | "
+                          << static_cast<double>(gridSize) * gridSize / seconds / 1e6 << " Mcells/s | speedup " << singleThreadSeconds / seconds
+                          << " | " << extractor.getSegmentCount() << " segments in " << polylineCount << " polylines\n";
+            }
+        }
+    }
+}
+
+
+// VulkanLab [--implicit <equation>]... [data file...]
+// VulkanLab --generate-data <path> <sample count>
+// VulkanLab --benchmark-contours
+// VulkanLab --benchmark-formats [function count]
+int main(int argc, char** argv)
 {
     HelloTriangleApplication app;
     try {
+        if (argc == 4 && std::strcmp(argv[1], "--generate-data") == 0) {
+            DataPlotSource::writeTestFile(argv[2], std::strtoull(argv[3], nullptr, 10));
+            return EXIT_SUCCESS;
+        }
+        if (argc == 2 && std::strcmp(argv[1], "--benchmark-contours") == 0) {
+            runContourBenchmark();
+            return EXIT_SUCCESS;
+        }
+        for (int i = 1; i < argc; i++) {
+            if (std::strcmp(argv[i], "--implicit") == 0 && i + 1 < argc) {
+                app.addImplicitEquation(argv[++i]);
+            } else if (std::strcmp(argv[i], "--benchmark-formats") == 0) {
+                app.setFormatBenchmark(i + 1 < argc ? static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10)) : 1000);
+            } else {
+                app.addDataFile(argv[i]);
+            }
+        }
         app.run();
     } catch(const std::exception& e) {
         std::cerr << e.what() << '\n';